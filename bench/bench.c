@@ -0,0 +1,504 @@
+/*
+ * Tusk RTOS kernel micro-benchmarks.
+ *
+ * Built as its own firmware image with `make bench` and run in QEMU with
+ * `make run-bench`. Timestamps come from port_get_cycles(), which counts
+ * SysTick clock cycles on the target. Every result is printed on one line
+ * so that runs can be compared across releases:
+ *
+ *   bench-start cycles_hz=<hz> tick_hz=<hz>
+ *   bench <name> ops=<n> cycles_per_op=<c> ns_per_op=<t>
+ *   bench-end status=<0|1>
+ *
+ * Latency results (context_switch, notify_switch, mutex_contended) include one
+ * port_get_cycles() call, whose own cost is reported as `timestamp`. With
+ * TUSK_USE_TRACE enabled every result includes the trace hooks on its path,
+ * and the cost of a single trace_record() is reported as well.
+ */
+
+#include "../include/tusk.h"
+#include "../include/sync.h"
+#include "../include/m_queue.h"
+#include "../include/ring.h"
+#include "../include/mem.h"
+#include "../include/port.h"
+#include "../include/serial.h"
+#include "../include/kernel.h"
+
+// --- Configuration ---
+#define BENCH_SWITCH_ROUNDS 1000
+#define BENCH_LOOP_ROUNDS 10000
+#define BENCH_STACK_SIZE 1024
+#define BENCH_POOL_BLOCKS 16
+#define BENCH_POOL_BLOCK_SIZE 32
+
+// The control task runs below every helper so that helpers always preempt it
+#define BENCH_CONTROL_PRIORITY 2
+#define BENCH_PEER_PRIORITY 3
+#define BENCH_HIGH_PRIORITY 4
+
+static rtos_semaphore_t done;
+
+static void report(const char *name, uint32_t ops, uint32_t cycles)
+{
+	uint32_t per_op = (cycles + ops / 2) / ops;
+
+	serial_print("bench ");
+	serial_print(name);
+	serial_print(" ops=");
+	serial_print_dec(ops);
+	serial_print(" cycles_per_op=");
+	serial_print_dec(per_op);
+	serial_print(" ns_per_op=");
+	serial_print_dec(per_op * 1000 / (PORT_CYCLES_HZ / 1000000));
+	serial_print("\r\n");
+}
+
+static void spawn(void (*handler)(void), uint8_t priority)
+{
+	if (tusk_create_task(handler, priority, BENCH_STACK_SIZE) == NULL) {
+		serial_print("bench-end status=1\r\n");
+		port_exit(1);
+	}
+}
+
+/* --- Timestamp overhead --- */
+
+static void bench_timestamp(void)
+{
+	uint32_t start = port_get_cycles();
+	for (int i = 0; i < BENCH_LOOP_ROUNDS; i++) {
+		(void)port_get_cycles();
+	}
+	report("timestamp", BENCH_LOOP_ROUNDS, port_get_cycles() - start);
+}
+
+/* --- Context switch latency: post in a low task -> woken high task runs --- */
+
+static rtos_semaphore_t wake;
+static volatile uint32_t switch_start;
+static uint32_t switch_cycles;
+
+static void switch_receiver(void)
+{
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_semaphore_wait(&wake);
+		switch_cycles += port_get_cycles() - switch_start;
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_context_switch(void)
+{
+	tusk_semaphore_init(&wake, 0);
+	switch_cycles = 0;
+
+	// The receiver preempts us and blocks on `wake` right away
+	spawn(switch_receiver, BENCH_HIGH_PRIORITY);
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		switch_start = port_get_cycles();
+		tusk_semaphore_post(&wake);
+	}
+	tusk_semaphore_wait(&done);
+	report("context_switch", BENCH_SWITCH_ROUNDS, switch_cycles);
+}
+
+/* --- Same latency with a direct-to-task notification instead of a semaphore --- */
+
+static void notify_receiver(void)
+{
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_notify_wait(0xFFFFFFFF, NULL, TUSK_WAIT_FOREVER);
+		switch_cycles += port_get_cycles() - switch_start;
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_notify_switch(void)
+{
+	switch_cycles = 0;
+
+	tcb_t *receiver = tusk_create_task(notify_receiver, BENCH_HIGH_PRIORITY,
+					   BENCH_STACK_SIZE);
+	if (receiver == NULL) {
+		serial_print("bench-end status=1\r\n");
+		port_exit(1);
+	}
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		switch_start = port_get_cycles();
+		tusk_notify(receiver, 0, TUSK_NOTIFY_INCREMENT);
+	}
+	tusk_semaphore_wait(&done);
+	report("notify_switch", BENCH_SWITCH_ROUNDS, switch_cycles);
+}
+
+/* --- Semaphore ping-pong between two equal-priority tasks --- */
+
+static rtos_semaphore_t ping, pong;
+static uint32_t pingpong_cycles;
+
+static void ping_task(void)
+{
+	uint32_t start = port_get_cycles();
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_semaphore_post(&pong);
+		tusk_semaphore_wait(&ping);
+	}
+	pingpong_cycles = port_get_cycles() - start;
+	tusk_semaphore_post(&done);
+}
+
+static void pong_task(void)
+{
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_semaphore_wait(&pong);
+		tusk_semaphore_post(&ping);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_semaphore_pingpong(void)
+{
+	tusk_semaphore_init(&ping, 0);
+	tusk_semaphore_init(&pong, 0);
+
+	spawn(pong_task, BENCH_PEER_PRIORITY);
+	spawn(ping_task, BENCH_PEER_PRIORITY);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report("semaphore_pingpong", BENCH_SWITCH_ROUNDS, pingpong_cycles);
+}
+
+/* --- Semaphore without contention: post then wait, nobody ever blocks --- */
+
+static void bench_semaphore_uncontended(void)
+{
+	static rtos_semaphore_t semaphore;
+
+	tusk_semaphore_init(&semaphore, 0);
+
+	uint32_t start = port_get_cycles();
+	for (int i = 0; i < BENCH_LOOP_ROUNDS; i++) {
+		tusk_semaphore_post(&semaphore);
+		tusk_semaphore_wait(&semaphore);
+	}
+	report("semaphore_uncontended", BENCH_LOOP_ROUNDS,
+	       port_get_cycles() - start);
+}
+
+/* --- Mutex --- */
+
+static tusk_mutex_t mutex;
+
+static void bench_mutex_uncontended(void)
+{
+	tusk_mutex_init(&mutex);
+
+	uint32_t start = port_get_cycles();
+	for (int i = 0; i < BENCH_LOOP_ROUNDS; i++) {
+		tusk_mutex_acquire(&mutex);
+		tusk_mutex_release(&mutex);
+	}
+	report("mutex_uncontended", BENCH_LOOP_ROUNDS,
+	       port_get_cycles() - start);
+}
+
+// Release by the owner -> blocked higher-priority waiter runs with the mutex
+static rtos_semaphore_t contend;
+static volatile uint32_t handoff_start;
+static uint32_t handoff_cycles;
+
+static void mutex_contender(void)
+{
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_semaphore_wait(&contend);
+		tusk_mutex_acquire(&mutex); // Blocks until the owner lets go
+		handoff_cycles += port_get_cycles() - handoff_start;
+		tusk_mutex_release(&mutex);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_mutex_contended(void)
+{
+	tusk_mutex_init(&mutex);
+	tusk_semaphore_init(&contend, 0);
+	handoff_cycles = 0;
+
+	spawn(mutex_contender, BENCH_HIGH_PRIORITY);
+	for (int i = 0; i < BENCH_SWITCH_ROUNDS; i++) {
+		tusk_mutex_acquire(&mutex);
+		tusk_semaphore_post(&contend); // The contender blocks on the mutex
+		handoff_start = port_get_cycles();
+		tusk_mutex_release(&mutex);
+	}
+	tusk_semaphore_wait(&done);
+	report("mutex_contended", BENCH_SWITCH_ROUNDS, handoff_cycles);
+}
+
+/* --- Message queue: fill it up, then drain it --- */
+
+static void bench_queue(void)
+{
+	static message_queue_t queue;
+	uint32_t send_cycles = 0;
+	uint32_t receive_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / QUEUE_MAX_MESSAGES;
+	message_t message;
+
+	queue_init(&queue);
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+			queue_send(&queue, &queue);
+		}
+		uint32_t middle = port_get_cycles();
+		for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+			queue_receive(&queue, &message);
+		}
+		receive_cycles += port_get_cycles() - middle;
+		send_cycles += middle - start;
+	}
+	report("queue_send", rounds * QUEUE_MAX_MESSAGES, send_cycles);
+	report("queue_receive", rounds * QUEUE_MAX_MESSAGES, receive_cycles);
+}
+
+/* --- Message queue batches: fill it up and drain it in one call each --- */
+
+static void bench_queue_batch(void)
+{
+	static message_queue_t queue;
+	message_t batch[QUEUE_MAX_MESSAGES];
+	uint32_t send_cycles = 0;
+	uint32_t receive_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / QUEUE_MAX_MESSAGES;
+
+	queue_init(&queue);
+	for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+		batch[i] = &queue;
+	}
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		queue_send_many(&queue, batch, QUEUE_MAX_MESSAGES);
+		uint32_t middle = port_get_cycles();
+		queue_receive_many(&queue, batch, QUEUE_MAX_MESSAGES);
+		receive_cycles += port_get_cycles() - middle;
+		send_cycles += middle - start;
+	}
+	report("queue_send_many", rounds * QUEUE_MAX_MESSAGES, send_cycles);
+	report("queue_receive_many", rounds * QUEUE_MAX_MESSAGES,
+	       receive_cycles);
+}
+
+/* --- SPSC byte ring: fill it up, then drain it --- */
+
+static void bench_ring(void)
+{
+	static uint8_t storage[QUEUE_MAX_MESSAGES];
+	tusk_ring_t ring;
+	uint32_t put_cycles = 0;
+	uint32_t get_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / QUEUE_MAX_MESSAGES;
+	uint8_t byte;
+
+	tusk_ring_init(&ring, storage, sizeof(storage));
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+			tusk_ring_put(&ring, (uint8_t)i);
+		}
+		uint32_t middle = port_get_cycles();
+		for (int i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+			tusk_ring_get(&ring, &byte);
+		}
+		get_cycles += port_get_cycles() - middle;
+		put_cycles += middle - start;
+	}
+	report("ring_put", rounds * QUEUE_MAX_MESSAGES, put_cycles);
+	report("ring_get", rounds * QUEUE_MAX_MESSAGES, get_cycles);
+}
+
+/* --- Fixed-block memory pool: allocate every block, then free them all --- */
+
+static void bench_mem_pool(void)
+{
+	static uint32_t buffer[BENCH_POOL_BLOCKS * BENCH_POOL_BLOCK_SIZE /
+			       sizeof(uint32_t)];
+	static mem_pool_t pool;
+	void *blocks[BENCH_POOL_BLOCKS];
+	uint32_t alloc_cycles = 0;
+	uint32_t free_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / BENCH_POOL_BLOCKS;
+
+	mem_pool_init(&pool, buffer, sizeof(buffer), BENCH_POOL_BLOCK_SIZE);
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			blocks[i] = mem_pool_alloc(&pool);
+		}
+		uint32_t middle = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			mem_pool_free(&pool, blocks[i]);
+		}
+		free_cycles += port_get_cycles() - middle;
+		alloc_cycles += middle - start;
+	}
+	report("mem_pool_alloc", rounds * BENCH_POOL_BLOCKS, alloc_cycles);
+	report("mem_pool_free", rounds * BENCH_POOL_BLOCKS, free_cycles);
+}
+
+/* --- Per-task cache in front of a pool: one batch per half cache --- */
+
+static void bench_mem_pool_cache(void)
+{
+	static uint32_t buffer[BENCH_POOL_BLOCKS * BENCH_POOL_BLOCK_SIZE /
+			       sizeof(uint32_t)];
+	static mem_pool_t pool;
+	static mem_pool_cache_t cache;
+	void *blocks[BENCH_POOL_BLOCKS];
+	uint32_t alloc_cycles = 0;
+	uint32_t free_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / BENCH_POOL_BLOCKS;
+
+	mem_pool_init(&pool, buffer, sizeof(buffer), BENCH_POOL_BLOCK_SIZE);
+	mem_pool_cache_init(&cache, &pool);
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			blocks[i] = mem_pool_cache_alloc(&cache);
+		}
+		uint32_t middle = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			mem_pool_cache_free(&cache, blocks[i]);
+		}
+		free_cycles += port_get_cycles() - middle;
+		alloc_cycles += middle - start;
+	}
+	mem_pool_cache_deinit(&cache);
+	report("mem_pool_cache_alloc", rounds * BENCH_POOL_BLOCKS, alloc_cycles);
+	report("mem_pool_cache_free", rounds * BENCH_POOL_BLOCKS, free_cycles);
+}
+
+/* --- Size-class allocator: mixed sizes across four classes --- */
+
+static void bench_malloc(void)
+{
+	static uint32_t small[BENCH_POOL_BLOCKS * 16 / sizeof(uint32_t)];
+	static uint32_t medium[BENCH_POOL_BLOCKS * 32 / sizeof(uint32_t)];
+	static uint32_t large[BENCH_POOL_BLOCKS * 64 / sizeof(uint32_t)];
+	static uint32_t huge[BENCH_POOL_BLOCKS * 128 / sizeof(uint32_t)];
+	const tusk_slab_class_t classes[] = {
+		{ 16, small, sizeof(small) },
+		{ 32, medium, sizeof(medium) },
+		{ 64, large, sizeof(large) },
+		{ 128, huge, sizeof(huge) },
+	};
+	void *blocks[BENCH_POOL_BLOCKS];
+	uint32_t alloc_cycles = 0;
+	uint32_t free_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / BENCH_POOL_BLOCKS;
+
+	tusk_slab_init(classes, sizeof(classes) / sizeof(classes[0]));
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			blocks[i] = tusk_malloc((size_t)(i * 8 + 1));
+		}
+		uint32_t middle = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			tusk_free(blocks[i]);
+		}
+		free_cycles += port_get_cycles() - middle;
+		alloc_cycles += middle - start;
+	}
+	report("tusk_malloc", rounds * BENCH_POOL_BLOCKS, alloc_cycles);
+	report("tusk_free", rounds * BENCH_POOL_BLOCKS, free_cycles);
+}
+
+/* --- TLSF heap: variable sizes, freed in a different order --- */
+
+static void bench_heap(void)
+{
+	static uint32_t region[4096 / sizeof(uint32_t)];
+	static tusk_heap_t heap;
+	void *blocks[BENCH_POOL_BLOCKS];
+	uint32_t alloc_cycles = 0;
+	uint32_t free_cycles = 0;
+	uint32_t rounds = BENCH_LOOP_ROUNDS / BENCH_POOL_BLOCKS;
+
+	tusk_heap_init(&heap, region, sizeof(region));
+	for (uint32_t round = 0; round < rounds; round++) {
+		uint32_t start = port_get_cycles();
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i++) {
+			blocks[i] = tusk_heap_malloc(&heap, (size_t)(i * 13 + 8));
+		}
+		uint32_t middle = port_get_cycles();
+		// Odd blocks first, so the even ones merge on both sides
+		for (int i = 1; i < BENCH_POOL_BLOCKS; i += 2) {
+			tusk_heap_free(&heap, blocks[i]);
+		}
+		for (int i = 0; i < BENCH_POOL_BLOCKS; i += 2) {
+			tusk_heap_free(&heap, blocks[i]);
+		}
+		free_cycles += port_get_cycles() - middle;
+		alloc_cycles += middle - start;
+	}
+	report("tusk_heap_malloc", rounds * BENCH_POOL_BLOCKS, alloc_cycles);
+	report("tusk_heap_free", rounds * BENCH_POOL_BLOCKS, free_cycles);
+}
+
+#if TUSK_USE_TRACE
+/* --- Cost of recording one trace event --- */
+
+static void bench_trace_record(void)
+{
+	uint32_t start = port_get_cycles();
+	for (int i = 0; i < BENCH_LOOP_ROUNDS; i++) {
+		trace_record(TRACE_TASK_DELAY, current_tcb, i);
+	}
+	report("trace_record", BENCH_LOOP_ROUNDS, port_get_cycles() - start);
+}
+#endif
+
+static void control_task(void)
+{
+	serial_print("bench-start cycles_hz=");
+	serial_print_dec(PORT_CYCLES_HZ);
+	serial_print(" tick_hz=");
+	serial_print_dec(TUSK_TICK_RATE_HZ);
+	serial_print("\r\n");
+
+	bench_timestamp();
+	bench_context_switch();
+	bench_notify_switch();
+	bench_semaphore_pingpong();
+	bench_semaphore_uncontended();
+	bench_mutex_uncontended();
+	bench_mutex_contended();
+	bench_queue();
+	bench_queue_batch();
+	bench_ring();
+	bench_mem_pool();
+	bench_mem_pool_cache();
+	bench_malloc();
+	bench_heap();
+#if TUSK_USE_TRACE
+	bench_trace_record();
+#endif
+
+	serial_print("bench-end status=0\r\n");
+	port_exit(0);
+}
+
+int main(void)
+{
+	uart_init();
+	tusk_init();
+	tusk_semaphore_init(&done, 0);
+
+	tusk_create_task(control_task, BENCH_CONTROL_PRIORITY, BENCH_STACK_SIZE);
+
+	tusk_start();
+
+	return 0; // Should never be reached
+}
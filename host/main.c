@@ -0,0 +1,2149 @@
+/*
+ * Host simulation of Tusk RTOS: scheduler, mutex and queue throughput
+ * benchmarks followed by stress tests of the kernel services.
+ *
+ * Build and run with `make host`. Every result is printed as one line:
+ *   bench <name> ops=<n> ns_per_op=<t>
+ *   stress <name> PASS|FAIL [details]
+ * The program exits with a non-zero status if any stress test fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/tusk.h"
+#include "../include/sync.h"
+#include "../include/m_queue.h"
+#include "../include/ring.h"
+#include "../include/stream.h"
+#include "../include/msgbuf.h"
+#include "../include/timer.h"
+#include "../include/kernel.h"
+#include "../include/serial.h"
+
+#define WORKER_STACK_SIZE 1024
+#define CONTROL_PRIORITY 2
+#define WORKER_PRIORITY 3
+
+#define PINGPONG_ROUNDS 200000
+#define MUTEX_OPS 1000000
+#define QUEUE_OPS 1000000
+#define PIPE_MESSAGES 200000
+#define CONTENDED_ROUNDS 200000
+
+static rtos_semaphore_t done;
+static int failures = 0;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void report_bench(const char *name, uint32_t ops, uint64_t elapsed)
+{
+	char line[128];
+
+	snprintf(line, sizeof(line), "bench %s ops=%u ns_per_op=%.1f\n", name,
+		 ops, (double)elapsed / ops);
+	serial_print(line);
+}
+
+static void report_stress(const char *name, int passed, const char *details)
+{
+	char line[160];
+
+	snprintf(line, sizeof(line), "stress %s %s%s%s\n", name,
+		 passed ? "PASS" : "FAIL", details[0] ? " " : "", details);
+	serial_print(line);
+	if (!passed) {
+		failures++;
+	}
+}
+
+/* Counts a failed check of a stress test in `errors`. */
+static void check(volatile uint32_t *errors, int condition)
+{
+	if (!condition) {
+		(*errors)++;
+	}
+}
+
+/* Runs `count` copies of `handler` at WORKER_PRIORITY and waits for all of them. */
+static void run_workers(void (*handler)(void), int count)
+{
+	for (int i = 0; i < count; i++) {
+		if (tusk_create_task(handler, WORKER_PRIORITY,
+				     WORKER_STACK_SIZE) == NULL) {
+			serial_print("error: cannot create worker task\n");
+			exit(2);
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		tusk_semaphore_wait(&done);
+	}
+}
+
+/* --- Benchmarks --- */
+
+// Two tasks hand a token back and forth: two context switches per round.
+static rtos_semaphore_t ping, pong;
+
+static void ping_task(void)
+{
+	for (int i = 0; i < PINGPONG_ROUNDS; i++) {
+		tusk_semaphore_post(&pong);
+		tusk_semaphore_wait(&ping);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void pong_task(void)
+{
+	for (int i = 0; i < PINGPONG_ROUNDS; i++) {
+		tusk_semaphore_wait(&pong);
+		tusk_semaphore_post(&ping);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_context_switch(void)
+{
+	tusk_semaphore_init(&ping, 0);
+	tusk_semaphore_init(&pong, 0);
+
+	uint64_t start = now_ns();
+	tusk_create_task(pong_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_create_task(ping_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report_bench("context_switch", 2 * PINGPONG_ROUNDS, now_ns() - start);
+}
+
+// The same hand-off with direct-to-task notifications instead of semaphores
+static tcb_t *notify_ping, *notify_pong;
+
+static void notify_ping_task(void)
+{
+	notify_ping = tusk_current_task();
+	for (int i = 0; i < PINGPONG_ROUNDS; i++) {
+		tusk_notify(notify_pong, 0, TUSK_NOTIFY_INCREMENT);
+		tusk_notify_wait(0xFFFFFFFF, NULL, TUSK_WAIT_FOREVER);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void notify_pong_task(void)
+{
+	for (int i = 0; i < PINGPONG_ROUNDS; i++) {
+		tusk_notify_wait(0xFFFFFFFF, NULL, TUSK_WAIT_FOREVER);
+		tusk_notify(notify_ping, 0, TUSK_NOTIFY_INCREMENT);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_notify(void)
+{
+	uint64_t start = now_ns();
+
+	// Each task runs as soon as it is created. Pong blocks right away, and
+	// ping publishes its own handle before it sends the first notification.
+	notify_pong = tusk_create_task(notify_pong_task, WORKER_PRIORITY,
+				       WORKER_STACK_SIZE);
+	tusk_create_task(notify_ping_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report_bench("notify_switch", 2 * PINGPONG_ROUNDS, now_ns() - start);
+}
+
+static tusk_mutex_t bench_mutex;
+
+static void bench_mutex_uncontended(void)
+{
+	tusk_mutex_init(&bench_mutex);
+
+	uint64_t start = now_ns();
+	for (int i = 0; i < MUTEX_OPS; i++) {
+		tusk_mutex_acquire(&bench_mutex);
+		tusk_mutex_release(&bench_mutex);
+	}
+	report_bench("mutex_acquire_release", MUTEX_OPS, now_ns() - start);
+}
+
+static void bench_queue(void)
+{
+	static message_queue_t queue;
+	message_t message;
+
+	queue_init(&queue);
+
+	uint64_t start = now_ns();
+	for (uintptr_t i = 0; i < QUEUE_OPS; i++) {
+		queue_send(&queue, (message_t)i);
+		queue_receive(&queue, &message);
+	}
+	report_bench("queue_send_receive", QUEUE_OPS, now_ns() - start);
+}
+
+static void bench_queue_batch(void)
+{
+	static message_queue_t queue;
+	message_t batch[QUEUE_MAX_MESSAGES];
+
+	queue_init(&queue);
+	for (uintptr_t i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+		batch[i] = (message_t)i;
+	}
+
+	uint64_t start = now_ns();
+	for (uint32_t i = 0; i < QUEUE_OPS; i += QUEUE_MAX_MESSAGES) {
+		queue_send_many(&queue, batch, QUEUE_MAX_MESSAGES);
+		queue_receive_many(&queue, batch, QUEUE_MAX_MESSAGES);
+	}
+	report_bench("queue_batch_send_receive", QUEUE_OPS, now_ns() - start);
+}
+
+static void bench_ring(void)
+{
+	static uint8_t storage[64];
+	tusk_ring_t ring;
+	uint8_t byte;
+
+	tusk_ring_init(&ring, storage, sizeof(storage));
+
+	uint64_t start = now_ns();
+	for (uint32_t i = 0; i < QUEUE_OPS; i++) {
+		tusk_ring_put(&ring, (uint8_t)i);
+		tusk_ring_get(&ring, &byte);
+	}
+	report_bench("ring_put_get", QUEUE_OPS, now_ns() - start);
+}
+
+// Bounded buffer: a producer and a consumer coupled by two counting semaphores
+static message_queue_t pipe_queue;
+static rtos_semaphore_t pipe_items, pipe_spaces;
+static uint32_t pipe_errors;
+
+static void producer_task(void)
+{
+	for (uintptr_t i = 0; i < PIPE_MESSAGES; i++) {
+		tusk_semaphore_wait(&pipe_spaces);
+		if (queue_send(&pipe_queue, (message_t)i) != 0) {
+			pipe_errors++;
+		}
+		tusk_semaphore_post(&pipe_items);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void consumer_task(void)
+{
+	message_t message;
+
+	for (uintptr_t i = 0; i < PIPE_MESSAGES; i++) {
+		tusk_semaphore_wait(&pipe_items);
+		if (queue_receive(&pipe_queue, &message) != 0 ||
+		    (uintptr_t)message != i) {
+			pipe_errors++;
+		}
+		tusk_semaphore_post(&pipe_spaces);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_queue_pipe(void)
+{
+	queue_init(&pipe_queue);
+	tusk_semaphore_init(&pipe_items, 0);
+	tusk_semaphore_init(&pipe_spaces, QUEUE_MAX_MESSAGES);
+	pipe_errors = 0;
+
+	uint64_t start = now_ns();
+	tusk_create_task(consumer_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_create_task(producer_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report_bench("queue_pipe", PIPE_MESSAGES, now_ns() - start);
+
+	char details[64];
+	snprintf(details, sizeof(details), "errors=%u", pipe_errors);
+	report_stress("queue_pipe_order", pipe_errors == 0, details);
+}
+
+// The same bounded buffer, with the queue itself blocking both ends
+static void blocking_producer_task(void)
+{
+	for (uintptr_t i = 0; i < PIPE_MESSAGES; i++) {
+		if (queue_send_timeout(&pipe_queue, (message_t)i,
+				       TUSK_WAIT_FOREVER) != 0) {
+			pipe_errors++;
+		}
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void blocking_consumer_task(void)
+{
+	message_t message;
+
+	for (uintptr_t i = 0; i < PIPE_MESSAGES; i++) {
+		if (queue_receive_timeout(&pipe_queue, &message,
+					  TUSK_WAIT_FOREVER) != 0 ||
+		    (uintptr_t)message != i) {
+			pipe_errors++;
+		}
+	}
+	tusk_semaphore_post(&done);
+}
+
+// And once more moving whole batches, some larger than the queue itself
+static void batch_producer_task(void)
+{
+	message_t batch[37];
+	uintptr_t next = 0;
+
+	for (uint32_t size = 1; next < PIPE_MESSAGES; size = size * 3 % 37 + 1) {
+		if (size > PIPE_MESSAGES - next) {
+			size = PIPE_MESSAGES - next;
+		}
+		for (uint32_t i = 0; i < size; i++) {
+			batch[i] = (message_t)(next + i);
+		}
+		if (queue_send_many_timeout(&pipe_queue, batch, size,
+					    TUSK_WAIT_FOREVER) != size) {
+			pipe_errors++;
+		}
+		next += size;
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void batch_consumer_task(void)
+{
+	message_t batch[23];
+	uintptr_t next = 0;
+
+	for (uint32_t max = 1; next < PIPE_MESSAGES; max = max * 5 % 23 + 1) {
+		uint32_t n = queue_receive_many_timeout(&pipe_queue, batch, max,
+							TUSK_WAIT_FOREVER);
+
+		if (n == 0 || n > max) {
+			pipe_errors++;
+		}
+		for (uint32_t i = 0; i < n; i++) {
+			if ((uintptr_t)batch[i] != next++) {
+				pipe_errors++;
+			}
+		}
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void bench_queue_batch_pipe(void)
+{
+	message_t batch[QUEUE_MAX_MESSAGES + 1] = { 0 };
+
+	queue_init(&pipe_queue);
+	pipe_errors = 0;
+
+	// Without waiting, a batch only moves what fits or is there
+	if (queue_send_many(&pipe_queue, batch, QUEUE_MAX_MESSAGES + 1) !=
+		    QUEUE_MAX_MESSAGES ||
+	    queue_send_many_timeout(&pipe_queue, batch, 1, 2) != 0 ||
+	    queue_receive_many(&pipe_queue, batch, QUEUE_MAX_MESSAGES + 1) !=
+		    QUEUE_MAX_MESSAGES ||
+	    queue_receive_many_timeout(&pipe_queue, batch, 1, 2) != 0) {
+		pipe_errors++;
+	}
+
+	uint64_t start = now_ns();
+	tusk_create_task(batch_consumer_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+	tusk_create_task(batch_producer_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report_bench("queue_batch_pipe", PIPE_MESSAGES, now_ns() - start);
+
+	char details[64];
+	snprintf(details, sizeof(details), "errors=%u", pipe_errors);
+	report_stress("queue_batch_pipe_order", pipe_errors == 0, details);
+}
+
+static void bench_queue_blocking_pipe(void)
+{
+	queue_init(&pipe_queue);
+	pipe_errors = 0;
+
+	uint64_t start = now_ns();
+	tusk_create_task(blocking_consumer_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+	tusk_create_task(blocking_producer_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+	report_bench("queue_blocking_pipe", PIPE_MESSAGES, now_ns() - start);
+
+	char details[64];
+	snprintf(details, sizeof(details), "errors=%u", pipe_errors);
+	report_stress("queue_blocking_pipe_order", pipe_errors == 0, details);
+}
+
+/* --- Stress Tests --- */
+
+// Several equal-priority tasks increment a shared counter under a mutex. The
+// tick preempts them at random points, including inside the critical region.
+#define CONTENDED_WORKERS 4
+static volatile uint32_t shared_counter;
+
+static void contended_task(void)
+{
+	for (int i = 0; i < CONTENDED_ROUNDS; i++) {
+		tusk_mutex_acquire(&bench_mutex);
+		uint32_t value = shared_counter;
+		for (volatile int spin = 0; spin < 2; spin++) {
+		}
+		shared_counter = value + 1;
+		tusk_mutex_release(&bench_mutex);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_mutex(void)
+{
+	char details[64];
+
+	tusk_mutex_init(&bench_mutex);
+	shared_counter = 0;
+
+	uint64_t start = now_ns();
+	run_workers(contended_task, CONTENDED_WORKERS);
+	report_bench("mutex_contended", CONTENDED_WORKERS * CONTENDED_ROUNDS,
+		     now_ns() - start);
+
+	snprintf(details, sizeof(details), "counter=%u expected=%u",
+		 shared_counter, CONTENDED_WORKERS * CONTENDED_ROUNDS);
+	report_stress("mutex_exclusion",
+		      shared_counter == CONTENDED_WORKERS * CONTENDED_ROUNDS,
+		      details);
+}
+
+// Classic priority inversion, through two nested mutexes: low holds `outer`,
+// mid holds `inner` and waits for `outer`, high waits for `inner`. Low must
+// inherit high's priority along the chain, so a busy task created between
+// mid and high only runs once both mutexes have been handed on.
+#define PI_LOW 3
+#define PI_MID 4
+#define PI_BUSY 5
+#define PI_HIGH 6
+#define PI_CEILING 7
+static tusk_mutex_t pi_outer, pi_inner, pi_ceiling;
+static volatile uint32_t pi_errors;
+static char pi_order[8];
+static volatile uint32_t pi_steps;
+
+static void pi_step(char id)
+{
+	if (pi_steps < sizeof(pi_order) - 1) {
+		pi_order[pi_steps++] = id;
+	}
+}
+
+static void pi_high_task(void)
+{
+	tusk_mutex_acquire(&pi_inner);
+	pi_step('H');
+	tusk_mutex_release(&pi_inner);
+	tusk_semaphore_post(&done);
+}
+
+static void pi_mid_task(void)
+{
+	tusk_mutex_acquire(&pi_inner);
+	tusk_mutex_acquire(&pi_outer);
+	pi_step('M');
+	// Still holds `inner`, which high is waiting for
+	check(&pi_errors, tusk_current_task()->priority == PI_HIGH);
+	tusk_mutex_release(&pi_outer);
+	tusk_mutex_release(&pi_inner);
+	check(&pi_errors, tusk_current_task()->priority == PI_MID);
+	tusk_semaphore_post(&done);
+}
+
+static void pi_busy_task(void)
+{
+	pi_step('B');
+	tusk_semaphore_post(&done);
+}
+
+static void pi_low_task(void)
+{
+	tcb_t *self = tusk_current_task();
+
+	tusk_mutex_acquire(&pi_outer);
+	tusk_create_task(pi_mid_task, PI_MID, WORKER_STACK_SIZE);
+	check(&pi_errors, self->priority == PI_MID);
+	tusk_create_task(pi_high_task, PI_HIGH, WORKER_STACK_SIZE);
+	check(&pi_errors, self->priority == PI_HIGH);
+	tusk_create_task(pi_busy_task, PI_BUSY, WORKER_STACK_SIZE);
+	pi_step('L');
+	tusk_mutex_release(&pi_outer);
+	check(&pi_errors, self->priority == PI_LOW);
+
+	// A ceiling mutex boosts on acquire, not on contention
+	tusk_mutex_acquire(&pi_ceiling);
+	check(&pi_errors, self->priority == PI_CEILING);
+	tusk_mutex_release(&pi_ceiling);
+	check(&pi_errors, self->priority == PI_LOW);
+	tusk_semaphore_post(&done);
+}
+
+static void stress_priority_inheritance(void)
+{
+	char details[64];
+
+	tusk_mutex_init(&pi_outer);
+	tusk_mutex_init(&pi_inner);
+	tusk_mutex_init_ceiling(&pi_ceiling, PI_CEILING);
+	pi_errors = 0;
+	pi_steps = 0;
+
+	tusk_create_task(pi_low_task, PI_LOW, WORKER_STACK_SIZE);
+	for (int i = 0; i < 4; i++) {
+		tusk_semaphore_wait(&done);
+	}
+	pi_order[pi_steps] = '\0';
+	check(&pi_errors, strcmp(pi_order, "LMHB") == 0);
+
+	snprintf(details, sizeof(details), "order=%s errors=%u", pi_order,
+		 pi_errors);
+	report_stress("priority_inheritance", pi_errors == 0, details);
+}
+
+// Timed waits must give up after their timeout, no earlier, and a mutex
+// waiter that gives up must take back the priority it lent the owner.
+#define TIMEOUT_TICKS 5
+static tusk_mutex_t timeout_mutex;
+static rtos_semaphore_t timeout_sem, holder_ready;
+static message_queue_t timeout_queue;
+static tcb_t *timeout_holder;
+static volatile uint32_t timeout_errors;
+
+static void timeout_holder_task(void)
+{
+	tusk_mutex_acquire(&timeout_mutex);
+	tusk_semaphore_post(&holder_ready);
+	tusk_delay(4 * TIMEOUT_TICKS);
+	tusk_mutex_release(&timeout_mutex);
+	tusk_semaphore_post(&done);
+}
+
+static void timeout_waiter_task(void)
+{
+	uint32_t start = rtos_ticks;
+
+	check(&timeout_errors,
+	      tusk_mutex_acquire_timeout(&timeout_mutex, TUSK_NO_WAIT) != 0);
+	check(&timeout_errors,
+	      tusk_mutex_acquire_timeout(&timeout_mutex, TIMEOUT_TICKS) != 0);
+	check(&timeout_errors, rtos_ticks - start >= TIMEOUT_TICKS);
+	check(&timeout_errors, timeout_holder->priority == WORKER_PRIORITY);
+
+	// The holder lets go well before this one expires
+	check(&timeout_errors,
+	      tusk_mutex_acquire_timeout(&timeout_mutex, 100) == 0);
+	tusk_mutex_release(&timeout_mutex);
+
+	start = rtos_ticks;
+	check(&timeout_errors,
+	      tusk_semaphore_wait_timeout(&timeout_sem, TUSK_NO_WAIT) != 0);
+	check(&timeout_errors,
+	      tusk_semaphore_wait_timeout(&timeout_sem, TIMEOUT_TICKS) != 0);
+	check(&timeout_errors, rtos_ticks - start >= TIMEOUT_TICKS);
+	// The expired wait must not have left a unit behind
+	check(&timeout_errors,
+	      tusk_semaphore_wait_timeout(&timeout_sem, TUSK_NO_WAIT) != 0);
+	tusk_semaphore_post(&timeout_sem);
+	check(&timeout_errors,
+	      tusk_semaphore_wait_timeout(&timeout_sem, TUSK_NO_WAIT) == 0);
+
+	// Expired queue waits neither lose nor invent a message
+	message_t message;
+	start = rtos_ticks;
+	check(&timeout_errors, queue_receive_timeout(&timeout_queue, &message,
+						     TIMEOUT_TICKS) != 0);
+	check(&timeout_errors, rtos_ticks - start >= TIMEOUT_TICKS);
+	for (uintptr_t i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+		check(&timeout_errors,
+		      queue_send_from_isr(&timeout_queue, (message_t)i) == 0);
+	}
+	check(&timeout_errors, queue_send_from_isr(&timeout_queue, NULL) != 0);
+	start = rtos_ticks;
+	check(&timeout_errors,
+	      queue_send_timeout(&timeout_queue, NULL, TIMEOUT_TICKS) != 0);
+	check(&timeout_errors, rtos_ticks - start >= TIMEOUT_TICKS);
+	for (uintptr_t i = 0; i < QUEUE_MAX_MESSAGES; i++) {
+		check(&timeout_errors,
+		      queue_receive_from_isr(&timeout_queue, &message) == 0 &&
+		      (uintptr_t)message == i);
+	}
+	check(&timeout_errors,
+	      queue_receive_from_isr(&timeout_queue, &message) != 0);
+	tusk_semaphore_post(&done);
+}
+
+static void stress_timeouts(void)
+{
+	char details[64];
+
+	tusk_mutex_init(&timeout_mutex);
+	tusk_semaphore_init(&timeout_sem, 0);
+	tusk_semaphore_init(&holder_ready, 0);
+	queue_init(&timeout_queue);
+	timeout_errors = 0;
+
+	timeout_holder = tusk_create_task(timeout_holder_task, WORKER_PRIORITY,
+					  WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&holder_ready);
+	tusk_create_task(timeout_waiter_task, WORKER_PRIORITY + 1,
+			 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+
+	snprintf(details, sizeof(details), "errors=%u", timeout_errors);
+	report_stress("timeouts", timeout_errors == 0, details);
+}
+
+// A recursive mutex stays held until every acquire has been released.
+static tusk_mutex_t recursive_mutex;
+static volatile uint32_t recursive_errors;
+
+static void recursive_probe_task(void)
+{
+	if (tusk_mutex_acquire_timeout(&recursive_mutex, TUSK_NO_WAIT) == 0) {
+		recursive_errors++;
+		tusk_mutex_release(&recursive_mutex);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_recursive_mutex(void)
+{
+	char details[64];
+	tcb_t *self = tusk_current_task();
+
+	tusk_mutex_init_recursive(&recursive_mutex);
+	recursive_errors = 0;
+
+	for (int i = 0; i < 3; i++) {
+		tusk_mutex_acquire(&recursive_mutex);
+	}
+	tusk_mutex_release(&recursive_mutex);
+	tusk_mutex_release(&recursive_mutex);
+	if (tusk_mutex_owner(&recursive_mutex) != self) {
+		recursive_errors++;
+	}
+	run_workers(recursive_probe_task, 1);
+	tusk_mutex_release(&recursive_mutex);
+	if (tusk_mutex_owner(&recursive_mutex) != NULL) {
+		recursive_errors++;
+	}
+
+	snprintf(details, sizeof(details), "errors=%u", recursive_errors);
+	report_stress("recursive_mutex", recursive_errors == 0, details);
+}
+
+// Auto-reload timers spread over every level of the timing wheel must fire
+// exactly once per period.
+#define STRESS_TIMERS 6
+static const uint32_t timer_periods[STRESS_TIMERS] = { 1, 7, 64, 65, 300, 1000 };
+
+typedef struct {
+	uint32_t start;
+	uint32_t fired;
+} timer_probe_t;
+
+static void probe_callback(tusk_timer_t *timer, void *arg)
+{
+	(void)timer;
+	((timer_probe_t *)arg)->fired++;
+}
+
+static void stress_timers(void)
+{
+	static tusk_timer_t timers[STRESS_TIMERS];
+	static timer_probe_t probes[STRESS_TIMERS];
+	char details[128];
+	int passed = 1;
+	int length = 0;
+
+	for (int i = 0; i < STRESS_TIMERS; i++) {
+		probes[i].fired = 0;
+		tusk_timer_create(&timers[i], probe_callback, &probes[i],
+				  timer_periods[i], TUSK_TIMER_AUTO_RELOAD);
+		port_disable_interrupts();
+		probes[i].start = rtos_ticks;
+		tusk_timer_start(&timers[i]);
+		port_enable_interrupts();
+	}
+
+	tusk_delay(2500);
+
+	for (int i = 0; i < STRESS_TIMERS; i++) {
+		port_disable_interrupts();
+		uint32_t stop = rtos_ticks;
+		tusk_timer_stop(&timers[i]);
+		port_enable_interrupts();
+
+		uint32_t expected = (stop - probes[i].start) / timer_periods[i];
+		if (probes[i].fired != expected) {
+			passed = 0;
+			length += snprintf(details + length,
+					   sizeof(details) - length,
+					   "period=%u fired=%u expected=%u ",
+					   timer_periods[i], probes[i].fired,
+					   expected);
+		}
+	}
+	if (passed) {
+		snprintf(details, sizeof(details), "timers=%d", STRESS_TIMERS);
+	}
+	report_stress("timer_wheel", passed, details);
+}
+
+// A callback that blocks on a mutex stalls the timer service. The ticks
+// that pass meanwhile must be caught up afterwards, not skipped, and the
+// tick must leave the blocked service on the mutex's wait queue.
+static tusk_mutex_t timer_gate;
+static volatile uint32_t gate_passed;
+
+static void gate_callback(tusk_timer_t *timer, void *arg)
+{
+	(void)timer;
+	(void)arg;
+	tusk_mutex_acquire(&timer_gate);
+	gate_passed = 1;
+	tusk_mutex_release(&timer_gate);
+}
+
+static void stress_timer_blocking_callback(void)
+{
+	static tusk_timer_t gate;
+	static tusk_timer_t probe_timers[2];
+	static timer_probe_t probes[2];
+	static const uint32_t periods[2] = { 1, 3 };
+	char details[96];
+	int passed;
+
+	gate_passed = 0;
+	tusk_mutex_init(&timer_gate);
+	tusk_mutex_acquire(&timer_gate);
+	tusk_timer_create(&gate, gate_callback, NULL, 2, TUSK_TIMER_ONE_SHOT);
+	for (int i = 0; i < 2; i++) {
+		probes[i].fired = 0;
+		tusk_timer_create(&probe_timers[i], probe_callback, &probes[i],
+				  periods[i], TUSK_TIMER_AUTO_RELOAD);
+	}
+	port_disable_interrupts();
+	uint32_t start = rtos_ticks;
+	tusk_timer_start(&gate);
+	tusk_timer_start(&probe_timers[0]);
+	tusk_timer_start(&probe_timers[1]);
+	port_enable_interrupts();
+
+	// Keep the service stuck in the callback for a while
+	tusk_delay(50);
+	uint32_t stuck = probes[0].fired;
+	tusk_mutex_release(&timer_gate);
+	tusk_delay(50);
+
+	port_disable_interrupts();
+	uint32_t stop = rtos_ticks;
+	tusk_timer_stop(&probe_timers[0]);
+	tusk_timer_stop(&probe_timers[1]);
+	port_enable_interrupts();
+
+	passed = gate_passed && stuck <= 2;
+	for (int i = 0; i < 2; i++) {
+		if (probes[i].fired != (stop - start) / periods[i]) {
+			passed = 0;
+		}
+	}
+	snprintf(details, sizeof(details), "stuck_at=%u fired=%u,%u expected=%u,%u",
+		 stuck, probes[0].fired, probes[1].fired, stop - start,
+		 (stop - start) / periods[1]);
+	report_stress("timer_blocking_callback", passed, details);
+}
+
+// Tasks sleeping for different amounts must never wake before their tick.
+// Waking later is only counted: the host may not run us for a while.
+#define SLEEPERS 6
+static volatile uint32_t early_wakeups;
+static volatile uint32_t late_wakeups;
+
+static void sleeper_task(void)
+{
+	static uint32_t next_seed = 1;
+	uint32_t seed = next_seed++;
+
+	for (int i = 0; i < 20; i++) {
+		seed = seed * 1103515245 + 12345;
+		uint32_t ticks = 1 + (seed >> 16) % 37;
+
+		port_disable_interrupts();
+		uint32_t target = rtos_ticks + ticks;
+		port_enable_interrupts();
+
+		tusk_delay(ticks);
+		if ((int32_t)(rtos_ticks - target) < 0) {
+			early_wakeups++;
+		} else if (rtos_ticks != target) {
+			late_wakeups++;
+		}
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_delay(void)
+{
+	char details[64];
+
+	early_wakeups = 0;
+	late_wakeups = 0;
+	run_workers(sleeper_task, SLEEPERS);
+	snprintf(details, sizeof(details), "early_wakeups=%u late_wakeups=%u",
+		 early_wakeups, late_wakeups);
+	report_stress("delay_accuracy", early_wakeups == 0, details);
+}
+
+// A waiter checks every notify action and that timeouts neither fire early
+// nor swallow notifications.
+static tcb_t *notify_waiter;
+static volatile uint32_t notify_errors;
+
+static void notify_waiter_task(void)
+{
+	uint32_t value;
+
+	// Nothing sent yet: polling fails, a timed wait lasts its full timeout
+	check(&notify_errors, tusk_notify_wait(0, &value, TUSK_NO_WAIT) != 0);
+	uint32_t start = rtos_ticks;
+	check(&notify_errors, tusk_notify_wait(0, &value, 5) != 0);
+	check(&notify_errors, rtos_ticks - start >= 5);
+
+	// Handshake: the control task sends while we block
+	tusk_semaphore_post(&done);
+	check(&notify_errors, tusk_notify_wait(0xFFFFFFFF, &value, 1000) == 0);
+	check(&notify_errors, value == 0x5);
+	check(&notify_errors, tusk_notify_wait(0xFFFFFFFF, &value, 1000) == 0);
+	check(&notify_errors, value == 3);
+	check(&notify_errors, tusk_notify_wait(0xFFFFFFFF, &value, 1000) == 0);
+	check(&notify_errors, value == 0xCAFE);
+	tusk_semaphore_post(&done);
+}
+
+static void stress_notify(void)
+{
+	char details[64];
+
+	notify_errors = 0;
+	notify_waiter = tusk_create_task(notify_waiter_task, WORKER_PRIORITY,
+					 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+
+	// The waiter preempts us as soon as it is woken, so every batch is sent
+	// with interrupts masked and it only sees the combined result
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	tusk_notify_from_isr(notify_waiter, 0x1, TUSK_NOTIFY_SET_BITS);
+	tusk_notify_from_isr(notify_waiter, 0x4, TUSK_NOTIFY_SET_BITS);
+	port_clear_interrupt_mask_from_isr(mask);
+
+	mask = port_set_interrupt_mask_from_isr();
+	for (int i = 0; i < 3; i++) {
+		tusk_notify_from_isr(notify_waiter, 0, TUSK_NOTIFY_INCREMENT);
+	}
+	port_clear_interrupt_mask_from_isr(mask);
+
+	mask = port_set_interrupt_mask_from_isr();
+	tusk_notify_from_isr(notify_waiter, 0x1234, TUSK_NOTIFY_OVERWRITE);
+	tusk_notify_from_isr(notify_waiter, 0xCAFE, TUSK_NOTIFY_OVERWRITE);
+	port_clear_interrupt_mask_from_isr(mask);
+	tusk_semaphore_wait(&done);
+
+	check(&notify_errors, tusk_notify(NULL, 0, TUSK_NOTIFY_SET_BITS) != 0);
+	snprintf(details, sizeof(details), "errors=%u", notify_errors);
+	report_stress("notify", notify_errors == 0, details);
+}
+
+// Waiters for any and for all of a set of flags are woken by the same set,
+// several clear-on-exit waiters on one flag are all released by a single set,
+// and a waiter whose flag never comes times out.
+#define EVENT_BROADCAST_WAITERS 4
+
+static tusk_event_group_t events;
+static volatile uint32_t event_errors;
+
+static void event_any_task(void)
+{
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x3, TUSK_EVENT_WAIT_ANY, 0,
+			      TUSK_WAIT_FOREVER) == 0x1);
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x2, TUSK_EVENT_WAIT_ANY, 0,
+			      TUSK_WAIT_FOREVER) == 0x3);
+	tusk_semaphore_post(&done);
+}
+
+static void event_all_task(void)
+{
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x3, TUSK_EVENT_WAIT_ALL, 1,
+			      TUSK_WAIT_FOREVER) == 0x3);
+	tusk_semaphore_post(&done);
+}
+
+static void event_timeout_task(void)
+{
+	uint32_t start = rtos_ticks;
+
+	check(&event_errors,
+	      (tusk_event_wait(&events, 0x4, TUSK_EVENT_WAIT_ANY, 0, 5) &
+	       0x4) == 0);
+	check(&event_errors, rtos_ticks - start >= 5);
+	tusk_semaphore_post(&done);
+}
+
+static void event_broadcast_task(void)
+{
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x8, TUSK_EVENT_WAIT_ANY, 1,
+			      1000) == 0x8);
+	tusk_semaphore_post(&done);
+}
+
+static void stress_event_groups(void)
+{
+	char details[64];
+
+	event_errors = 0;
+	tusk_event_init(&events);
+
+	// Every waiter runs at once and blocks before we continue
+	tusk_create_task(event_any_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_create_task(event_all_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_create_task(event_timeout_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+
+	// 0x1 only satisfies the any-waiter; 0x2 then releases both, and the
+	// all-waiter clears both flags once every waiter has been checked
+	tusk_event_set(&events, 0x1);
+	check(&event_errors, tusk_event_set(&events, 0x2) == 0x3);
+	check(&event_errors, tusk_event_clear(&events, 0) == 0);
+	for (int i = 0; i < 3; i++) {
+		tusk_semaphore_wait(&done);
+	}
+
+	for (int i = 0; i < EVENT_BROADCAST_WAITERS; i++) {
+		tusk_create_task(event_broadcast_task, WORKER_PRIORITY,
+				 WORKER_STACK_SIZE);
+	}
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	tusk_event_set_from_isr(&events, 0x8);
+	port_clear_interrupt_mask_from_isr(mask);
+	for (int i = 0; i < EVENT_BROADCAST_WAITERS; i++) {
+		tusk_semaphore_wait(&done);
+	}
+	check(&event_errors, tusk_event_clear(&events, 0) == 0);
+
+	// Satisfied without blocking; the flags stay unless asked to clear
+	tusk_event_set(&events, 0x30);
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x10, TUSK_EVENT_WAIT_ALL, 0,
+			      TUSK_NO_WAIT) == 0x30);
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x30, TUSK_EVENT_WAIT_ALL, 1,
+			      TUSK_NO_WAIT) == 0x30);
+	check(&event_errors,
+	      tusk_event_wait(&events, 0x10, TUSK_EVENT_WAIT_ANY, 0,
+			      TUSK_NO_WAIT) == 0);
+
+	snprintf(details, sizeof(details), "errors=%u", event_errors);
+	report_stress("event_groups", event_errors == 0, details);
+}
+
+// A timer callback stands in for an interrupt handler feeding a task through
+// a ring. Both ends take turns between single bytes, bulk copies and spans,
+// and the tick preempts the consumer at arbitrary points.
+#define RING_BYTES 40000
+#define RING_BYTES_PER_TICK 100
+
+static uint8_t ring_storage[64];
+static tusk_ring_t stress_ring;
+static uint32_t ring_produced;
+static uint32_t ring_style;
+static volatile uint32_t ring_errors;
+
+static void ring_producer_callback(tusk_timer_t *timer, void *arg)
+{
+	uint8_t chunk[RING_BYTES_PER_TICK];
+	uint32_t len = RING_BYTES - ring_produced;
+	uint32_t written = 0;
+
+	(void)timer;
+	(void)arg;
+	if (len > RING_BYTES_PER_TICK) {
+		len = RING_BYTES_PER_TICK;
+	}
+
+	switch (ring_style++ % 3) {
+	case 0:
+		while (written < len &&
+		       tusk_ring_put(&stress_ring,
+				     (uint8_t)(ring_produced + written)) == 0) {
+			written++;
+		}
+		break;
+	case 1:
+		for (uint32_t i = 0; i < len; i++) {
+			chunk[i] = (uint8_t)(ring_produced + i);
+		}
+		written = tusk_ring_write(&stress_ring, chunk, len);
+		break;
+	default:
+		for (int part = 0; part < 2 && written < len; part++) {
+			uint8_t *span;
+			uint32_t n = tusk_ring_write_span(&stress_ring, &span);
+
+			if (n > len - written) {
+				n = len - written;
+			}
+			for (uint32_t i = 0; i < n; i++) {
+				span[i] = (uint8_t)(ring_produced + written + i);
+			}
+			tusk_ring_commit(&stress_ring, n);
+			written += n;
+		}
+		break;
+	}
+	ring_produced += written;
+}
+
+static void ring_consumer_task(void)
+{
+	uint8_t chunk[48];
+	uint32_t consumed = 0;
+
+	for (uint32_t style = 0; consumed < RING_BYTES; style++) {
+		uint32_t n = 0;
+
+		if (style % 3 == 0) {
+			uint8_t byte;
+
+			if (tusk_ring_get(&stress_ring, &byte) == 0) {
+				chunk[0] = byte;
+				n = 1;
+			}
+		} else if (style % 3 == 1) {
+			n = tusk_ring_read(&stress_ring, chunk, sizeof(chunk));
+		} else {
+			const uint8_t *span;
+
+			n = tusk_ring_read_span(&stress_ring, &span);
+			if (n > sizeof(chunk)) {
+				n = sizeof(chunk);
+			}
+			for (uint32_t i = 0; i < n; i++) {
+				chunk[i] = span[i];
+			}
+			tusk_ring_release(&stress_ring, n);
+		}
+
+		for (uint32_t i = 0; i < n; i++) {
+			if (chunk[i] != (uint8_t)(consumed + i)) {
+				ring_errors++;
+			}
+		}
+		consumed += n;
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_ring_buffer(void)
+{
+	static tusk_timer_t producer;
+	char details[64];
+
+	ring_produced = 0;
+	ring_style = 0;
+	ring_errors = 0;
+	tusk_ring_init(&stress_ring, ring_storage, sizeof(ring_storage));
+	if (tusk_ring_init(&stress_ring, ring_storage, 48) == 0) {
+		ring_errors++;
+	}
+
+	tusk_timer_create(&producer, ring_producer_callback, NULL, 1,
+			  TUSK_TIMER_AUTO_RELOAD);
+	tusk_timer_start(&producer);
+	tusk_create_task(ring_consumer_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_timer_stop(&producer);
+
+	if (tusk_ring_count(&stress_ring) != 0 ||
+	    tusk_ring_space(&stress_ring) != sizeof(ring_storage)) {
+		ring_errors++;
+	}
+	snprintf(details, sizeof(details), "bytes=%u errors=%u", RING_BYTES,
+		 ring_errors);
+	report_stress("ring_buffer", ring_errors == 0, details);
+}
+
+// A writer streams bytes and variable-length messages in place to a more
+// urgent reader, which sleeps until enough has been committed. The writer
+// only backs off when the buffer is full.
+#define STREAM_BYTES 200000
+#define STREAM_MESSAGES 20000
+#define STREAM_MAX_MESSAGE 40
+
+static uint32_t stream_storage[64];
+static tusk_stream_buffer_t stream_buffer;
+static tusk_message_buffer_t message_buffer;
+static volatile uint32_t stream_errors;
+
+static void stream_writer_task(void)
+{
+	uint32_t written = 0;
+
+	for (uint32_t chunk = 1; written < STREAM_BYTES; chunk = chunk * 7 % 97) {
+		uint8_t *data;
+		uint32_t want = (chunk < STREAM_BYTES - written) ?
+					chunk :
+					STREAM_BYTES - written;
+		uint32_t len = tusk_stream_reserve(&stream_buffer, want, &data);
+
+		if (len == 0) {
+			tusk_delay(1);
+			continue;
+		}
+		for (uint32_t i = 0; i < len; i++) {
+			data[i] = (uint8_t)(written + i);
+		}
+		tusk_stream_commit(&stream_buffer, len);
+		written += len;
+	}
+
+	for (uint32_t n = 0; n < STREAM_MESSAGES; n++) {
+		uint32_t len = n % (STREAM_MAX_MESSAGE + 1);
+		uint8_t *payload;
+
+		while ((payload = tusk_message_reserve(&message_buffer, len)) ==
+		       NULL) {
+			tusk_delay(1);
+		}
+		for (uint32_t i = 0; i < len; i++) {
+			payload[i] = (uint8_t)(n + i);
+		}
+		tusk_message_commit(&message_buffer, len);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stream_reader_task(void)
+{
+	uint32_t consumed = 0;
+
+	for (uint32_t want = 1; consumed < STREAM_BYTES; want = want * 5 % 89) {
+		if (want > STREAM_BYTES - consumed) {
+			want = STREAM_BYTES - consumed;
+		}
+		if (tusk_stream_wait(&stream_buffer, want, 1000) != 0) {
+			stream_errors++;
+			break;
+		}
+		// The bytes may wrap around the end of the storage
+		for (uint32_t got = 0; got < want;) {
+			const uint8_t *data;
+			uint32_t len = tusk_stream_peek(&stream_buffer, &data);
+
+			if (len > want - got) {
+				len = want - got;
+			}
+			for (uint32_t i = 0; i < len; i++) {
+				if (data[i] != (uint8_t)(consumed + i)) {
+					stream_errors++;
+				}
+			}
+			tusk_stream_release(&stream_buffer, len);
+			consumed += len;
+			got += len;
+		}
+	}
+
+	for (uint32_t n = 0; n < STREAM_MESSAGES; n++) {
+		const uint8_t *payload;
+		uint32_t len;
+
+		if (tusk_message_wait(&message_buffer, 1000) != 0) {
+			stream_errors++;
+			break;
+		}
+		payload = tusk_message_peek(&message_buffer, &len);
+		if (payload == NULL || len != n % (STREAM_MAX_MESSAGE + 1)) {
+			stream_errors++;
+			break;
+		}
+		for (uint32_t i = 0; i < len; i++) {
+			if (payload[i] != (uint8_t)(n + i)) {
+				stream_errors++;
+			}
+		}
+		tusk_message_release(&message_buffer);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_stream_buffers(void)
+{
+	static uint32_t message_storage[32];
+	char details[64];
+
+	stream_errors = 0;
+	tusk_stream_init(&stream_buffer, (uint8_t *)stream_storage,
+			 sizeof(stream_storage));
+	tusk_message_buffer_init(&message_buffer, (uint8_t *)message_storage,
+				 sizeof(message_storage));
+
+	// Nothing committed yet: a bounded wait fails, an oversized one at once
+	if (tusk_stream_wait(&stream_buffer, 1, 2) == 0 ||
+	    tusk_stream_wait(&stream_buffer, sizeof(stream_storage) + 1,
+			     TUSK_WAIT_FOREVER) == 0 ||
+	    tusk_message_reserve(&message_buffer, sizeof(message_storage)) != NULL) {
+		stream_errors++;
+	}
+
+	tusk_create_task(stream_reader_task, WORKER_PRIORITY + 1,
+			 WORKER_STACK_SIZE);
+	tusk_create_task(stream_writer_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_semaphore_wait(&done);
+
+	snprintf(details, sizeof(details), "bytes=%u messages=%u errors=%u",
+		 STREAM_BYTES, STREAM_MESSAGES, stream_errors);
+	report_stress("stream_buffers", stream_errors == 0, details);
+}
+
+// A producer fans every pool buffer out to several consumers without copying
+// it. Each consumer checks the payload and drops its reference; the buffer
+// must be back in its pool once the last one has done so.
+#define MSGBUF_CONSUMERS 3
+#define MSGBUF_MESSAGES 5000
+#define MSGBUF_BLOCKS 8
+#define MSGBUF_BLOCK_SIZE 64
+
+static mem_pool_t msgbuf_pool;
+static message_queue_t msgbuf_queues[MSGBUF_CONSUMERS];
+static volatile uint32_t msgbuf_errors;
+static volatile uint32_t msgbuf_consumer_index;
+
+static void msgbuf_producer_task(void)
+{
+	message_queue_t *const queues[MSGBUF_CONSUMERS] = {
+		&msgbuf_queues[0], &msgbuf_queues[1], &msgbuf_queues[2]
+	};
+
+	for (uint32_t n = 0; n < MSGBUF_MESSAGES; n++) {
+		tusk_msgbuf_t *buf;
+
+		while ((buf = tusk_msgbuf_alloc(&msgbuf_pool)) == NULL) {
+			tusk_delay(1);
+		}
+		uint32_t *payload = tusk_msgbuf_data(buf);
+		buf->length = sizeof(uint32_t) * 2;
+		payload[0] = n;
+		payload[1] = ~n;
+
+		if (tusk_msgbuf_broadcast(queues, MSGBUF_CONSUMERS, buf,
+					  TUSK_WAIT_FOREVER) != MSGBUF_CONSUMERS) {
+			msgbuf_errors++;
+		}
+		tusk_msgbuf_unref(buf);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void msgbuf_consumer_task(void)
+{
+	message_queue_t *queue = &msgbuf_queues[msgbuf_consumer_index++];
+
+	for (uint32_t n = 0; n < MSGBUF_MESSAGES; n++) {
+		tusk_msgbuf_t *buf = tusk_msgbuf_receive(queue, 1000);
+
+		if (buf == NULL) {
+			msgbuf_errors++;
+			break;
+		}
+		uint32_t *payload = tusk_msgbuf_data(buf);
+		if (buf->length != sizeof(uint32_t) * 2 || payload[0] != n ||
+		    payload[1] != ~n) {
+			msgbuf_errors++;
+		}
+		tusk_msgbuf_unref(buf);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_msgbuf(void)
+{
+	static uint32_t storage[MSGBUF_BLOCKS * MSGBUF_BLOCK_SIZE /
+				sizeof(uint32_t)];
+	char details[64];
+
+	msgbuf_errors = 0;
+	msgbuf_consumer_index = 0;
+	mem_pool_init(&msgbuf_pool, storage, sizeof(storage), MSGBUF_BLOCK_SIZE);
+	for (int i = 0; i < MSGBUF_CONSUMERS; i++) {
+		queue_init(&msgbuf_queues[i]);
+		tusk_create_task(msgbuf_consumer_task, WORKER_PRIORITY,
+				 WORKER_STACK_SIZE);
+	}
+	tusk_create_task(msgbuf_producer_task, WORKER_PRIORITY,
+			 WORKER_STACK_SIZE);
+	for (int i = 0; i < MSGBUF_CONSUMERS + 1; i++) {
+		tusk_semaphore_wait(&done);
+	}
+
+	size_t leaked = mem_pool_get_used_count(&msgbuf_pool);
+	snprintf(details, sizeof(details), "messages=%u leaked=%u errors=%u",
+		 MSGBUF_MESSAGES, (unsigned)leaked, msgbuf_errors);
+	report_stress("msgbuf_fanout", msgbuf_errors == 0 && leaked == 0,
+		      details);
+}
+
+// Tasks and an interrupt handler allocate and free blocks of one small pool
+// at the same time. Every block is stamped with its owner, so a block handed
+// out twice is caught, and the counters must add up once everybody is done.
+// A lock-free pool is used from the host's simulated tick interrupt, which
+// can land between a task's read of the free list head and its CAS; a
+// mutex-protected one can only be used from a timer callback.
+#define POOL_WORKERS 3
+// Long enough for the interrupt to land inside a CAS window many times
+#define POOL_TICKS 1000
+#define POOL_BLOCKS 6
+#define POOL_BLOCK_SIZE 16
+
+static mem_pool_t shared_pool;
+static volatile uint32_t pool_errors;
+static volatile uint32_t pool_worker_id;
+static volatile uint32_t pool_isr_allocs;
+static uint32_t pool_deadline;
+
+static int pool_use_block(uint32_t owner)
+{
+	volatile uint32_t *block = mem_pool_alloc(&shared_pool);
+
+	if (block == NULL) {
+		return 0;
+	}
+	block[1] = owner;
+	for (volatile int spin = 0; spin < 2; spin++) {
+	}
+	if (block[1] != owner) {
+		pool_errors++;
+	}
+	mem_pool_free(&shared_pool, (void *)block);
+	return 1;
+}
+
+#if TUSK_MEM_POOL_LOCK_FREE
+static volatile uint32_t *pool_isr_held;
+
+static void pool_release_isr_block(void)
+{
+	if (pool_isr_held != NULL) {
+		if (pool_isr_held[1] != 0xFFFFFFFF) {
+			pool_errors++;
+		}
+		mem_pool_free(&shared_pool, (void *)pool_isr_held);
+		pool_isr_held = NULL;
+	}
+}
+
+static void pool_isr(void)
+{
+	volatile uint32_t *first = mem_pool_alloc(&shared_pool);
+	volatile uint32_t *second = mem_pool_alloc(&shared_pool);
+
+	// Keeping the second block until the next interrupt while the first
+	// goes back on top puts the same block at the head with a different
+	// successor: the ABA case a preempted task's CAS must not fall for.
+	pool_release_isr_block();
+	if (first != NULL) {
+		pool_isr_allocs++;
+		mem_pool_free(&shared_pool, (void *)first);
+	}
+	if (second != NULL) {
+		pool_isr_allocs++;
+		second[1] = 0xFFFFFFFF;
+		pool_isr_held = second;
+	}
+}
+#else
+static void pool_isr_callback(tusk_timer_t *timer, void *arg)
+{
+	(void)timer;
+	(void)arg;
+	pool_isr_allocs += pool_use_block(0xFFFFFFFF);
+}
+#endif
+
+static void pool_worker_task(void)
+{
+	uint32_t owner = pool_worker_id++;
+
+	while ((int32_t)(rtos_ticks - pool_deadline) < 0) {
+		pool_use_block(owner);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_mem_pool(void)
+{
+	static uint32_t storage[POOL_BLOCKS * POOL_BLOCK_SIZE / sizeof(uint32_t)];
+	char details[96];
+
+	pool_errors = 0;
+	pool_worker_id = 0;
+	pool_isr_allocs = 0;
+	mem_pool_init(&shared_pool, storage, sizeof(storage), POOL_BLOCK_SIZE);
+	pool_deadline = rtos_ticks + POOL_TICKS;
+#if TUSK_MEM_POOL_LOCK_FREE
+	port_host_set_isr_hook(pool_isr);
+	run_workers(pool_worker_task, POOL_WORKERS);
+	port_host_set_isr_hook(NULL);
+	pool_release_isr_block();
+#else
+	static tusk_timer_t isr;
+
+	tusk_timer_create(&isr, pool_isr_callback, NULL, 1,
+			  TUSK_TIMER_AUTO_RELOAD);
+	tusk_timer_start(&isr);
+	run_workers(pool_worker_task, POOL_WORKERS);
+	tusk_timer_stop(&isr);
+#endif
+
+	// Every block must still be reachable from the free list exactly once
+	void *blocks[POOL_BLOCKS + 1];
+	uint32_t drained = 0;
+	while (drained <= POOL_BLOCKS &&
+	       (blocks[drained] = mem_pool_alloc(&shared_pool)) != NULL) {
+		drained++;
+	}
+	for (uint32_t i = 0; i < drained; i++) {
+		mem_pool_free(&shared_pool, blocks[i]);
+	}
+
+	size_t used = mem_pool_get_used_count(&shared_pool);
+	size_t peak = mem_pool_get_peak_count(&shared_pool);
+	snprintf(details, sizeof(details),
+		 "errors=%u isr_allocs=%u free=%u used=%u peak=%u", pool_errors,
+		 pool_isr_allocs, drained, (unsigned)used, (unsigned)peak);
+	report_stress("mem_pool", pool_errors == 0 && drained == POOL_BLOCKS &&
+					  used == 0 && peak == POOL_BLOCKS,
+		      details);
+}
+
+// Tasks put private caches in front of one shared pool and pass blocks
+// around through them. The last workers return without flushing, so the
+// blocks left in their caches only get back through task deletion. One more
+// task is deleted from outside while it sleeps with a filled cache, which
+// must be flushed all the same.
+#define CACHE_WORKERS 3
+#define CACHE_ROUNDS 50000
+#define CACHE_HELD 6
+#define CACHE_POOL_BLOCKS 16
+
+static mem_pool_t cache_pool;
+static mem_pool_cache_t worker_caches[CACHE_WORKERS];
+static mem_pool_cache_t victim_cache;
+static volatile uint32_t cache_errors;
+static volatile uint32_t cache_exhausted;
+static volatile uint32_t cache_worker_id;
+
+static void cache_worker_task(void)
+{
+	uint32_t id = cache_worker_id++;
+	mem_pool_cache_t *cache = &worker_caches[id];
+	volatile uint32_t *held[CACHE_HELD] = { NULL };
+
+	if (!mem_pool_cache_init(cache, &cache_pool)) {
+		cache_errors++;
+	}
+	for (int i = 0; i < CACHE_ROUNDS; i++) {
+		int slot = i % CACHE_HELD;
+
+		if (held[slot] != NULL) {
+			if (held[slot][1] != id) {
+				cache_errors++;
+			}
+			mem_pool_cache_free(cache, (void *)held[slot]);
+		}
+		held[slot] = mem_pool_cache_alloc(cache);
+		if (held[slot] == NULL) {
+			cache_exhausted++;
+			continue;
+		}
+		held[slot][1] = id;
+	}
+	for (int slot = 0; slot < CACHE_HELD; slot++) {
+		mem_pool_cache_free(cache, (void *)held[slot]);
+	}
+	if (id == 0) {
+		mem_pool_cache_deinit(cache);
+		if (cache->owner != NULL || cache->count != 0) {
+			cache_errors++;
+		}
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void cache_victim_task(void)
+{
+	void *block;
+
+	if (!mem_pool_cache_init(&victim_cache, &cache_pool)) {
+		cache_errors++;
+	}
+	block = mem_pool_cache_alloc(&victim_cache);
+	mem_pool_cache_free(&victim_cache, block);
+	tusk_semaphore_post(&done);
+	tusk_delay(100000);
+}
+
+static void stress_mem_pool_cache(void)
+{
+	static uint32_t storage[CACHE_POOL_BLOCKS * POOL_BLOCK_SIZE /
+				sizeof(uint32_t)];
+	char details[96];
+
+	cache_errors = 0;
+	cache_exhausted = 0;
+	cache_worker_id = 0;
+	mem_pool_init(&cache_pool, storage, sizeof(storage), POOL_BLOCK_SIZE);
+	run_workers(cache_worker_task, CACHE_WORKERS);
+
+	// Deleting the workers must have emptied the caches they kept
+	for (int i = 0; i < CACHE_WORKERS; i++) {
+		if (worker_caches[i].count != 0 ||
+		    worker_caches[i].owner != NULL) {
+			cache_errors++;
+		}
+	}
+
+	tcb_t *victim = tusk_create_task(cache_victim_task, WORKER_PRIORITY,
+					 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	if (victim == NULL || victim_cache.count == 0 ||
+	    tusk_delete_task(victim) != 0 || victim_cache.owner != NULL ||
+	    victim_cache.count != 0) {
+		cache_errors++;
+	}
+
+	size_t used = mem_pool_get_used_count(&cache_pool);
+	snprintf(details, sizeof(details), "errors=%u exhausted=%u used=%u",
+		 cache_errors, cache_exhausted, (unsigned)used);
+	report_stress("mem_pool_cache", cache_errors == 0 && used == 0,
+		      details);
+}
+
+// Tasks allocate random sizes from four size classes and stamp every byte.
+// Each request must land in the smallest class that fits unless that one is
+// full, and the class statistics must add up afterwards.
+#define SLAB_WORKERS 3
+#define SLAB_ROUNDS 20000
+#define SLAB_HELD 4
+
+static uint32_t slab_small[2 * 16 / sizeof(uint32_t)];
+static uint32_t slab_medium[2 * 32 / sizeof(uint32_t)];
+static uint32_t slab_large[2 * 64 / sizeof(uint32_t)];
+static uint32_t slab_huge[3 * 256 / sizeof(uint32_t)];
+static volatile uint32_t slab_errors;
+static volatile uint32_t slab_failures;
+static volatile uint32_t slab_spills;
+static volatile uint32_t slab_worker_id;
+
+static size_t slab_class_size(size_t size)
+{
+	return size <= 16 ? 16 : size <= 32 ? 32 : size <= 64 ? 64 : 256;
+}
+
+static void slab_worker_task(void)
+{
+	uint8_t *held[SLAB_HELD] = { NULL };
+	size_t sizes[SLAB_HELD] = { 0 };
+	uint8_t stamp = (uint8_t)(0x10 * ++slab_worker_id);
+	uint32_t seed = stamp;
+
+	for (int i = 0; i < SLAB_ROUNDS; i++) {
+		int slot = i % SLAB_HELD;
+
+		if (held[slot] != NULL) {
+			for (size_t b = 0; b < sizes[slot]; b++) {
+				if (held[slot][b] != stamp) {
+					slab_errors++;
+					break;
+				}
+			}
+			tusk_free(held[slot]);
+		}
+
+		seed = seed * 1103515245 + 12345;
+		sizes[slot] = (seed >> 16) % 200;
+		held[slot] = tusk_malloc(sizes[slot]);
+		if (held[slot] == NULL) {
+			slab_failures++;
+			continue;
+		}
+		// Must come from a class that fits, a larger one counts as a spill
+		tusk_slab_stats_t stats[4];
+		tusk_slab_get_stats(stats, 4);
+		for (int c = 0; c < 4; c++) {
+			uint8_t *start = (uint8_t *)(c == 0 ? slab_small :
+						     c == 1 ? slab_medium :
+						     c == 2 ? slab_large :
+							      slab_huge);
+			if (held[slot] < start ||
+			    held[slot] >= start + stats[c].num_blocks *
+							  stats[c].block_size) {
+				continue;
+			}
+			if (stats[c].block_size < slab_class_size(sizes[slot])) {
+				slab_errors++;
+			} else if (stats[c].block_size >
+				   slab_class_size(sizes[slot])) {
+				slab_spills++;
+			}
+		}
+		for (size_t b = 0; b < sizes[slot]; b++) {
+			held[slot][b] = stamp;
+		}
+	}
+	for (int slot = 0; slot < SLAB_HELD; slot++) {
+		tusk_free(held[slot]);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_malloc(void)
+{
+	// Deliberately out of order
+	const tusk_slab_class_t classes[] = {
+		{ 64, slab_large, sizeof(slab_large) },
+		{ 16, slab_small, sizeof(slab_small) },
+		{ 256, slab_huge, sizeof(slab_huge) },
+		{ 32, slab_medium, sizeof(slab_medium) },
+	};
+	tusk_slab_stats_t stats[4];
+	uint32_t allocations = 0;
+	char details[112];
+
+	slab_errors = 0;
+	slab_failures = 0;
+	slab_spills = 0;
+	slab_worker_id = 0;
+	if (!tusk_slab_init(classes, 4) || tusk_malloc(257) != NULL) {
+		slab_errors++;
+	}
+	run_workers(slab_worker_task, SLAB_WORKERS);
+
+	size_t count = tusk_slab_get_stats(stats, 4);
+	for (size_t c = 0; c < count; c++) {
+		allocations += stats[c].allocations;
+		if (stats[c].used_blocks != 0 ||
+		    stats[c].peak_blocks > stats[c].num_blocks ||
+		    (c > 0 && stats[c].block_size <= stats[c - 1].block_size)) {
+			slab_errors++;
+		}
+	}
+	if (count != 4 || slab_spills == 0 ||
+	    allocations + slab_failures != SLAB_WORKERS * SLAB_ROUNDS) {
+		slab_errors++;
+	}
+	snprintf(details, sizeof(details), "errors=%u allocations=%u spills=%u failures=%u",
+		 slab_errors, allocations, slab_spills, slab_failures);
+	report_stress("malloc_size_classes", slab_errors == 0, details);
+}
+
+// Tasks allocate random sizes and alignments from one TLSF heap, stamp
+// every byte and check it on release. Once everything is freed, merging
+// must have turned the heap back into a single free block.
+#define HEAP_WORKERS 3
+#define HEAP_ROUNDS 20000
+#define HEAP_HELD 8
+
+static uint64_t heap_region[4096 / sizeof(uint64_t)];
+static tusk_heap_t heap;
+static volatile uint32_t heap_errors;
+static volatile uint32_t heap_worker_id;
+
+static void heap_worker_task(void)
+{
+	uint8_t *held[HEAP_HELD] = { NULL };
+	size_t sizes[HEAP_HELD] = { 0 };
+	uint8_t stamp = (uint8_t)(0x10 * ++heap_worker_id);
+	uint32_t seed = stamp;
+
+	for (int i = 0; i < HEAP_ROUNDS; i++) {
+		int slot = (int)((seed >> 8) % HEAP_HELD);
+
+		if (held[slot] != NULL) {
+			for (size_t b = 0; b < sizes[slot]; b++) {
+				if (held[slot][b] != stamp) {
+					heap_errors++;
+					break;
+				}
+			}
+			tusk_heap_free(&heap, held[slot]);
+		}
+
+		seed = seed * 1103515245 + 12345;
+		// Mostly small records with the occasional large frame
+		sizes[slot] = 1 + (seed >> 16) % ((seed & 0x7) ? 96 : 1500);
+		if ((seed & 0x30) == 0) {
+			size_t alignment = (size_t)16 << ((seed >> 6) & 3);
+			held[slot] = tusk_heap_malloc_aligned(&heap, sizes[slot],
+							      alignment);
+			if (((uintptr_t)held[slot] & (alignment - 1)) != 0) {
+				heap_errors++;
+			}
+		} else {
+			held[slot] = tusk_heap_malloc(&heap, sizes[slot]);
+			if (((uintptr_t)held[slot] & (TUSK_HEAP_ALIGNMENT - 1)) !=
+			    0) {
+				heap_errors++;
+			}
+		}
+		if (held[slot] == NULL) {
+			continue;
+		}
+		for (size_t b = 0; b < sizes[slot]; b++) {
+			held[slot][b] = stamp;
+		}
+	}
+	for (int slot = 0; slot < HEAP_HELD; slot++) {
+		tusk_heap_free(&heap, held[slot]);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_heap(void)
+{
+	tusk_heap_stats_t before;
+	tusk_heap_stats_t after;
+	char details[128];
+
+	heap_errors = 0;
+	heap_worker_id = 0;
+	if (!tusk_heap_init(&heap, heap_region, sizeof(heap_region)) ||
+	    tusk_heap_malloc(&heap, sizeof(heap_region)) != NULL ||
+	    tusk_heap_malloc_aligned(&heap, 16, 24) != NULL) {
+		heap_errors++;
+	}
+	tusk_heap_get_stats(&heap, &before);
+	run_workers(heap_worker_task, HEAP_WORKERS);
+	tusk_heap_get_stats(&heap, &after);
+
+	if (after.used_blocks != 0 || after.used_bytes != 0 ||
+	    after.free_blocks != 1 || after.free_bytes != before.free_bytes ||
+	    after.largest_free_block != before.free_bytes ||
+	    after.fragmentation != 0 || after.failures <= before.failures ||
+	    after.peak_used_bytes > after.total_bytes) {
+		heap_errors++;
+	}
+	snprintf(details, sizeof(details),
+		 "errors=%u allocations=%u failures=%u peak_used=%u free=%u",
+		 heap_errors, after.allocations, after.failures,
+		 (unsigned)after.peak_used_bytes, (unsigned)after.free_bytes);
+	report_stress("tlsf_heap", heap_errors == 0, details);
+}
+
+// Deleting a task that still holds mutexes must hand them to their waiters
+// instead of leaving them locked by a dead TCB. One holder is deleted by the
+// control task while a more urgent task waits on it; another simply returns.
+// Finally a task that takes and drops a mutex in a tight loop is deleted at
+// whatever point the tick catches it, which must never leave it locked.
+#define ORPHAN_CHURN_ROUNDS 300
+static tusk_mutex_t orphan_plain;
+static tusk_mutex_t orphan_recursive;
+static volatile uint32_t orphan_errors;
+
+static void orphan_holder_task(void)
+{
+	tusk_mutex_acquire(&orphan_plain);
+	tusk_mutex_acquire(&orphan_recursive);
+	tusk_mutex_acquire(&orphan_recursive);
+	tusk_semaphore_post(&done);
+	tusk_delay(100000);
+}
+
+static void orphan_waiter_task(void)
+{
+	if (tusk_mutex_acquire_timeout(&orphan_plain, 500) != 0 ||
+	    tusk_mutex_acquire_timeout(&orphan_recursive, 500) != 0) {
+		orphan_errors++;
+	} else {
+		tusk_mutex_release(&orphan_recursive);
+		tusk_mutex_release(&orphan_plain);
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void orphan_exit_task(void)
+{
+	tusk_mutex_acquire(&orphan_plain);
+	tusk_semaphore_post(&done);
+}
+
+static void orphan_churn_task(void)
+{
+	while (1) {
+		tusk_mutex_acquire(&orphan_plain);
+		tusk_mutex_release(&orphan_plain);
+	}
+}
+
+static void stress_delete_mutex_owner(void)
+{
+	char details[64];
+
+	orphan_errors = 0;
+	tusk_mutex_init(&orphan_plain);
+	tusk_mutex_init_recursive(&orphan_recursive);
+
+	tcb_t *holder = tusk_create_task(orphan_holder_task, WORKER_PRIORITY,
+					 WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	tusk_create_task(orphan_waiter_task, WORKER_PRIORITY + 1,
+			 WORKER_STACK_SIZE);
+	// The waiter is blocked now and lends its priority to the holder
+	if (holder->priority != WORKER_PRIORITY + 1 ||
+	    tusk_delete_task(holder) != 0) {
+		orphan_errors++;
+	}
+	tusk_semaphore_wait(&done);
+
+	// A task returning from its handler goes through the same path
+	tusk_create_task(orphan_exit_task, WORKER_PRIORITY, WORKER_STACK_SIZE);
+	tusk_semaphore_wait(&done);
+	if (tusk_mutex_acquire_timeout(&orphan_plain, 10) != 0) {
+		orphan_errors++;
+	} else {
+		tusk_mutex_release(&orphan_plain);
+	}
+	if (tusk_mutex_owner(&orphan_plain) != NULL ||
+	    tusk_mutex_owner(&orphan_recursive) != NULL ||
+	    orphan_recursive.depth != 0) {
+		orphan_errors++;
+	}
+
+	// Runs below us, so waking from the delay preempts it anywhere
+	for (int i = 0; i < ORPHAN_CHURN_ROUNDS; i++) {
+		tcb_t *churn = tusk_create_task(orphan_churn_task,
+						CONTROL_PRIORITY - 1,
+						WORKER_STACK_SIZE);
+		tusk_delay(1);
+		if (churn == NULL || tusk_delete_task(churn) != 0 ||
+		    tusk_mutex_owner(&orphan_plain) != NULL) {
+			orphan_errors++;
+			break;
+		}
+	}
+
+	snprintf(details, sizeof(details), "errors=%u", orphan_errors);
+	report_stress("delete_mutex_owner", orphan_errors == 0, details);
+}
+
+// Short-lived tasks that return from their handler must give back their TCB
+// and stack, so the pool never runs dry. Stack sizes the arena can never
+// hold, including ones that would wrap when rounded up, must be refused.
+#define CHURN_ROUNDS 2000
+
+static void short_lived_task(void)
+{
+	tusk_semaphore_post(&done);
+}
+
+static void stress_task_churn(void)
+{
+	char details[64];
+	uint32_t failed = 0;
+
+	for (int i = 0; i < CHURN_ROUNDS; i++) {
+		if (tusk_create_task(short_lived_task, WORKER_PRIORITY,
+				     WORKER_STACK_SIZE) == NULL) {
+			failed++;
+			continue;
+		}
+		tusk_semaphore_wait(&done);
+		// Let the idle task reclaim the zombie now and then
+		if (i % 100 == 0) {
+			tusk_delay(1);
+		}
+	}
+	if (tusk_create_task(short_lived_task, WORKER_PRIORITY, SIZE_MAX) !=
+		    NULL ||
+	    tusk_create_task(short_lived_task, WORKER_PRIORITY,
+			     TUSK_STACK_ARENA_SIZE + 1) != NULL) {
+		failed++;
+	}
+	snprintf(details, sizeof(details), "rounds=%d create_failures=%u",
+		 CHURN_ROUNDS, failed);
+	report_stress("task_churn", failed == 0, details);
+}
+
+#if TUSK_USE_EDF
+// Three periodic tasks fill the CPU exactly; a fourth that would push the
+// density past 1 must be turned away. Every job checks that no other EDF
+// task with an earlier deadline is ready, and that it was released exactly
+// one period after the previous job and not before its release time.
+// None of them may miss a deadline. Afterwards a task that keeps running
+// past its declared WCET must have its misses counted.
+#define EDF_TASKS 3
+#define EDF_RUN_TICKS 1000
+#define EDF_OVERRUN_TICKS 15
+
+typedef struct {
+	uint32_t period;
+	uint32_t deadline;
+	uint32_t wcet;
+} edf_params_t;
+
+// Densities 256 + 512 + 256 = 1024, the limit
+static const edf_params_t edf_params[EDF_TASKS] = {
+	{ 20, 20, 5 },
+	{ 40, 30, 15 },
+	{ 100, 40, 10 },
+};
+static tcb_t *volatile edf_tasks[EDF_TASKS];
+static volatile uint32_t edf_jobs[EDF_TASKS];
+static volatile uint32_t edf_errors;
+static volatile uint8_t edf_stop;
+
+static void edf_task(void)
+{
+	tcb_t *self = tusk_current_task();
+	uint32_t last_release = 0;
+	int id = 0;
+
+	// The control task fills in the handles before it lets us run
+	while (edf_tasks[id] != self) {
+		id++;
+	}
+
+	while (!edf_stop) {
+		port_disable_interrupts();
+		for (int i = 0; i < EDF_TASKS; i++) {
+			tcb_t *other = edf_tasks[i];
+			if (other != self && other->state == TASK_READY &&
+			    (int32_t)(other->absolute_deadline -
+				      self->absolute_deadline) < 0) {
+				edf_errors++;
+			}
+		}
+		if ((int32_t)(rtos_ticks - self->release_time) < 0 ||
+		    (edf_jobs[id] > 0 &&
+		     self->release_time - last_release != edf_params[id].period) ||
+		    self->absolute_deadline - self->release_time !=
+			    edf_params[id].deadline) {
+			edf_errors++;
+		}
+		last_release = self->release_time;
+		port_enable_interrupts();
+
+		edf_jobs[id]++;
+		tusk_wait_next_period();
+	}
+	tusk_semaphore_post(&done);
+}
+
+// Declared with a WCET of 2 and a deadline of 10, but runs for 15 ticks
+static void edf_overrun_task(void)
+{
+	tcb_t *self = tusk_current_task();
+
+	while (!edf_stop) {
+		while ((int32_t)(rtos_ticks - self->release_time) <
+		       EDF_OVERRUN_TICKS) {
+		}
+		tusk_wait_next_period();
+	}
+	tusk_semaphore_post(&done);
+}
+
+static void stress_edf(void)
+{
+	char details[128];
+	tcb_t *rejected;
+
+	edf_errors = 0;
+	edf_stop = 0;
+
+	// Release every first job on the same tick
+	port_disable_interrupts();
+	uint32_t start = rtos_ticks;
+	for (int i = 0; i < EDF_TASKS; i++) {
+		edf_jobs[i] = 0;
+		edf_tasks[i] = tusk_create_periodic_task(
+			edf_task, edf_params[i].period, edf_params[i].deadline,
+			edf_params[i].wcet, WORKER_STACK_SIZE);
+		if (edf_tasks[i] == NULL) {
+			port_enable_interrupts();
+			report_stress("edf", 0, "admission rejected a feasible set");
+			return;
+		}
+	}
+	rejected = tusk_create_periodic_task(edf_task, 50, 10, 1,
+					     WORKER_STACK_SIZE);
+	port_enable_interrupts();
+
+	tusk_delay(EDF_RUN_TICKS);
+	edf_stop = 1;
+	port_disable_interrupts();
+	uint32_t elapsed = rtos_ticks - start;
+	for (int i = 0; i < EDF_TASKS; i++) {
+		if (tusk_get_deadline_misses(edf_tasks[i]) != 0) {
+			edf_errors++;
+		}
+	}
+	port_enable_interrupts();
+	for (int i = 0; i < EDF_TASKS; i++) {
+		tusk_semaphore_wait(&done);
+	}
+
+	// Every task released a job per period, give or take the one in flight
+	for (int i = 0; i < EDF_TASKS; i++) {
+		uint32_t expected = elapsed / edf_params[i].period + 1;
+		if (edf_jobs[i] + 1 < expected || edf_jobs[i] > expected + 1) {
+			edf_errors++;
+		}
+	}
+
+	// The finished tasks gave back their share of the CPU. The probe is
+	// deleted again before it gets to run.
+	port_disable_interrupts();
+	tcb_t *full = tusk_create_periodic_task(edf_task, 10, 10, 10,
+						WORKER_STACK_SIZE);
+	if (full != NULL) {
+		tusk_delete_task(full);
+	}
+	port_enable_interrupts();
+	if (rejected != NULL || full == NULL) {
+		edf_errors++;
+	}
+
+	edf_stop = 0;
+	tcb_t *overrun = tusk_create_periodic_task(edf_overrun_task, 20, 10, 2,
+						   WORKER_STACK_SIZE);
+	uint32_t misses = 0;
+	if (overrun == NULL) {
+		edf_errors++;
+	} else {
+		tusk_delay(5 * 20);
+		edf_stop = 1;
+		port_disable_interrupts();
+		misses = tusk_get_deadline_misses(overrun);
+		port_enable_interrupts();
+		tusk_semaphore_wait(&done);
+		if (misses == 0) {
+			edf_errors++;
+		}
+	}
+
+	snprintf(details, sizeof(details),
+		 "errors=%u jobs=%u,%u,%u ticks=%u overrun_misses=%u",
+		 edf_errors, edf_jobs[0], edf_jobs[1], edf_jobs[2], elapsed,
+		 misses);
+	report_stress("edf", edf_errors == 0, details);
+}
+#endif
+
+#if TUSK_USE_STATS
+// The run time charged to the live tasks can never exceed the time since
+// tusk_start() (finished workers took theirs with them), and every live task
+// must have been switched in at least once.
+static void stress_stats(void)
+{
+	tusk_task_stats_t stats[MAX_TASKS + 2];
+	uint64_t total = 0;
+	uint64_t sum = 0;
+	uint32_t never_ran = 0;
+	char details[96];
+
+	uint32_t count = tusk_get_task_stats(stats, MAX_TASKS + 2, &total);
+	for (uint32_t i = 0; i < count; i++) {
+		sum += stats[i].run_time;
+		if (stats[i].switch_count == 0) {
+			never_ran++;
+		}
+	}
+	snprintf(details, sizeof(details),
+		 "tasks=%u run_time_sum=%llu total=%llu never_ran=%u", count,
+		 (unsigned long long)sum, (unsigned long long)total, never_ran);
+	report_stress("task_stats", count >= 3 && sum <= total && never_ran == 0,
+		      details);
+}
+#endif
+
+static void control_task(void)
+{
+	bench_context_switch();
+	bench_notify();
+	bench_mutex_uncontended();
+	bench_queue();
+	bench_queue_batch();
+	bench_ring();
+	bench_queue_pipe();
+	bench_queue_blocking_pipe();
+	bench_queue_batch_pipe();
+	stress_mutex();
+	stress_priority_inheritance();
+	stress_timeouts();
+	stress_recursive_mutex();
+	stress_timers();
+	stress_timer_blocking_callback();
+	stress_delay();
+	stress_notify();
+	stress_event_groups();
+	stress_ring_buffer();
+	stress_stream_buffers();
+	stress_msgbuf();
+	stress_mem_pool();
+	stress_mem_pool_cache();
+	stress_malloc();
+	stress_heap();
+	stress_delete_mutex_owner();
+	stress_task_churn();
+#if TUSK_USE_EDF
+	stress_edf();
+#endif
+#if TUSK_USE_STATS
+	stress_stats();
+#endif
+
+	serial_print(failures == 0 ? "result PASS\n" : "result FAIL\n");
+	exit(failures == 0 ? 0 : 1);
+}
+
+int main(void)
+{
+	uart_init();
+	tusk_init();
+	tusk_semaphore_init(&done, 0);
+
+	tusk_create_task(control_task, CONTROL_PRIORITY, WORKER_STACK_SIZE);
+
+	tusk_start();
+
+	return 0; // Should never be reached
+}
@@ -0,0 +1,174 @@
+/**
+ * @file kernel.h
+ * @brief Kernel-internal interface shared between Tusk RTOS modules.
+ * @author Dimitrios Papakonstantinou
+ *
+ * This header is not part of the public API. It exposes the scheduler state
+ * and the list helpers that kernel services outside of tusk.c (such as the
+ * software timers) need in order to block and wake tasks. Unless stated
+ * otherwise, every function declared here must be called with interrupts
+ * disabled.
+ */
+
+#ifndef KERNEL_H_
+#define KERNEL_H_
+
+#include <stdint.h>
+#include "tusk.h"
+#include "port.h"
+#include "trace.h"
+
+// --- Scheduler State (defined in tusk.c) ---
+extern tcb_t *current_tcb;
+extern volatile uint32_t rtos_ticks;
+
+/**
+ * @brief Requests that the scheduler runs as soon as interrupts allow it.
+ */
+static inline void trigger_context_switch(void)
+{
+	port_trigger_context_switch();
+}
+
+/**
+ * @brief Prepares a TCB and its initial stack frame.
+ *
+ * The task is not made ready; call add_to_ready_list() once it may run.
+ * Until then the TCB is invisible to the scheduler, so unlike the other
+ * functions here this one may run with interrupts enabled. With
+ * TUSK_USE_STATS it paints the whole stack.
+ *
+ * @param tcb The TCB to initialize.
+ * @param stack The lowest word of the task's stack.
+ * @param stack_size The size of the stack in bytes.
+ * @param task_handler The task entry point.
+ * @param priority The task priority.
+ */
+void init_tcb(tcb_t *tcb, uint32_t *stack, size_t stack_size,
+	      void (*task_handler)(void), uint8_t priority);
+
+/**
+ * @brief Makes a blocked task ready and preempts the caller if it is more urgent.
+ */
+void wake_task(tcb_t *task);
+
+/**
+ * @brief Takes the running task off its ready queue and marks it blocked.
+ *
+ * The caller is responsible for calling trigger_context_switch() once it has
+ * put the task on whatever list it waits on.
+ */
+void block_current_task(void);
+
+/**
+ * @brief Blocks the running task, optionally for at most `timeout` ticks.
+ *
+ * Like block_current_task(), but unless `timeout` is TUSK_WAIT_FOREVER the
+ * task is also put on the delay list. If the tick handler wakes it from
+ * there, it takes the task off its wait queue and sets its `timed_out` flag,
+ * which this function clears. wake_task() takes the task off the delay list
+ * if it is woken earlier.
+ */
+void block_current_task_timeout(uint32_t timeout);
+
+void add_to_ready_list(tcb_t *task);
+void remove_from_ready_list(tcb_t *task);
+void add_to_delay_list(tcb_t *task, uint32_t wakeup_time);
+void remove_from_delay_list(tcb_t *task);
+static inline void wait_queue_init(wait_queue_t *queue)
+{
+	queue->head = NULL;
+	queue->tail = NULL;
+}
+
+/**
+ * @brief Queues a task on a wait queue, behind every waiter of equal or higher priority.
+ *
+ * The search starts at the tail, so it takes constant time unless the task
+ * is more urgent than the waiter queued last.
+ */
+void add_to_wait_list(wait_queue_t *queue, tcb_t *task);
+
+/**
+ * @brief Dequeues and returns the most urgent waiter, or NULL if there is none.
+ */
+tcb_t *remove_from_wait_list(wait_queue_t *queue);
+
+/**
+ * @brief Takes a task off whatever wait queue it is on, in constant time.
+ */
+void unlink_from_wait_list(tcb_t *task);
+
+// --- Software Timer Service (defined in timer.c) ---
+
+/**
+ * @brief Resets the timing wheel and creates the timer service task.
+ *
+ * Called once from tusk_init().
+ */
+void timer_service_init(void);
+
+/**
+ * @brief Checks whether the timer service has work on the current tick.
+ *
+ * Called from SysTick_Handler after rtos_ticks has been advanced. This only
+ * looks at a single wheel slot, so its cost does not depend on the number of
+ * active timers.
+ *
+ * @return 1 if the timer service task was woken and a context switch is needed, 0 otherwise.
+ */
+uint8_t timer_service_tick(void);
+
+/**
+ * @brief Returns the TCB of the timer service task.
+ */
+tcb_t *timer_service_task(void);
+
+// --- Memory Pool Caches (defined in mem.c) ---
+
+/**
+ * @brief Flushes and unregisters every pool cache of a task being deleted.
+ *
+ * Called by tusk_delete_task() with interrupts enabled, since a pool may be
+ * protected by a mutex. The task must either be the caller or be off every
+ * list, so that it never uses its caches again.
+ */
+void mem_pool_cache_flush_task(tcb_t *task);
+
+/**
+ * @brief Unregisters the pool caches a task was in the middle of using.
+ *
+ * Their blocks stay in them. Interrupts must be disabled.
+ */
+void mem_pool_cache_detach_busy(tcb_t *task);
+
+// --- Scheduler Trace (defined in trace.c) ---
+
+#if TUSK_USE_TRACE
+/**
+ * @brief Appends an event to the trace ring buffer.
+ *
+ * Lock-free and safe from tasks and interrupt handlers, with or without
+ * interrupts disabled.
+ *
+ * @param event One of the TRACE_* event ids.
+ * @param task The task the event is about.
+ * @param arg An event-specific argument.
+ */
+void trace_record(uint8_t event, const tcb_t *task, uint16_t arg);
+
+/**
+ * @brief Returns the trace index of a task: its TCB table index, TRACE_TASK_IDLE or TRACE_TASK_KERNEL.
+ */
+uint8_t trace_task_index(const tcb_t *task);
+
+#define TRACE_EVENT(event, task, arg) \
+	trace_record((event), (task), (uint16_t)(arg))
+#else
+#define TRACE_EVENT(event, task, arg) ((void)0)
+#endif
+
+// Turns a kernel object address into a 16-bit trace argument
+#define TRACE_OBJECT(object) ((uint16_t)((uintptr_t)(object) >> 2))
+
+#endif // KERNEL_H_
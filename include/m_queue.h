@@ -10,6 +10,11 @@
  * This implementation is thread-safe for single-core processors, as critical
  * sections of the queue operations are protected by disabling interrupts
  * to ensure atomic access.
+ *
+ * Tasks can block on a full or empty queue, optionally with a timeout. A send
+ * to a queue that receivers are waiting on hands the message straight to the
+ * most urgent receiver. A receive from a full queue that senders are waiting
+ * on moves the most urgent sender's message into the freed slot.
  */
 
 #ifndef M_QUEUE_H_
@@ -17,7 +22,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
-#include "core_cm4.h"
+#include "tusk.h"
 
 // --- Configuration ---
 
@@ -70,6 +75,18 @@ typedef struct {
      * @brief The current number of messages in the queue.
      */
 	volatile uint32_t count;
+
+	/**
+     * @var senders
+     * @brief Tasks blocked sending to the full queue, most urgent first.
+     */
+	wait_queue_t senders;
+
+	/**
+     * @var receivers
+     * @brief Tasks blocked receiving from the empty queue, most urgent first.
+     */
+	wait_queue_t receivers;
 } message_queue_t;
 
 // --- Function Prototypes ---
@@ -87,9 +104,8 @@ void queue_init(message_queue_t *q);
 /**
  * @brief Sends a message to the back of the queue.
  *
- * This function adds a message pointer to the queue. This is a non-blocking call.
- * For thread safety on single-core processors, this function should be
- * called from within a critical section (e.g., with interrupts disabled).
+ * This function adds a message pointer to the queue. This is a non-blocking
+ * call, equivalent to queue_send_timeout() with TUSK_NO_WAIT.
  *
  * @param q Pointer to the `message_queue_t` structure.
  * @param message The message (a `void` pointer) to send.
@@ -98,12 +114,63 @@ void queue_init(message_queue_t *q);
  */
 int32_t queue_send(message_queue_t *q, message_t message);
 
+/**
+ * @brief Sends a message, waiting for room if the queue is full.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param message The message (a `void` pointer) to send.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return `0` on success.
+ * @return `-1` if the queue stayed full until the timeout expired.
+ */
+int32_t queue_send_timeout(message_queue_t *q, message_t message,
+			   uint32_t timeout);
+
+/**
+ * @brief Sends a message from an interrupt handler without blocking.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param message The message (a `void` pointer) to send.
+ * @return `0` on success.
+ * @return `-1` if the queue is full.
+ */
+int32_t queue_send_from_isr(message_queue_t *q, message_t message);
+
+/**
+ * @brief Sends up to `count` messages in one critical section.
+ *
+ * Waiting receivers are handed one message each, and the rest are copied
+ * into the queue in at most two contiguous runs. This is a non-blocking
+ * call, equivalent to queue_send_many_timeout() with TUSK_NO_WAIT.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param messages The messages to send, in order.
+ * @param count The number of messages to send.
+ * @return The number of messages sent, from the front of `messages`.
+ */
+uint32_t queue_send_many(message_queue_t *q, const message_t *messages,
+			 uint32_t count);
+
+/**
+ * @brief Sends `count` messages, waiting for room while the queue is full.
+ *
+ * The task is woken once for each run of free slots a receiver makes, not
+ * once per message.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param messages The messages to send, in order.
+ * @param count The number of messages to send.
+ * @param timeout The total number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return The number of messages sent, less than `count` if the timeout expired.
+ */
+uint32_t queue_send_many_timeout(message_queue_t *q, const message_t *messages,
+				 uint32_t count, uint32_t timeout);
+
 /**
  * @brief Receives a message from the front of the queue.
  *
- * This function retrieves a message pointer from the queue. This is a non-blocking call.
- * For thread safety on single-core processors, this function should be
- * called from within a critical section (e.g., with interrupts disabled).
+ * This function retrieves a message pointer from the queue. This is a
+ * non-blocking call, equivalent to queue_receive_timeout() with TUSK_NO_WAIT.
  *
  * @param q Pointer to the `message_queue_t` structure.
  * @param message Pointer to a `message_t` variable where the received message pointer will be stored.
@@ -112,4 +179,54 @@ int32_t queue_send(message_queue_t *q, message_t message);
  */
 int32_t queue_receive(message_queue_t *q, message_t *message);
 
+/**
+ * @brief Receives a message, waiting for one if the queue is empty.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param message Pointer to a `message_t` variable where the received message pointer will be stored.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return `0` on success.
+ * @return `-1` if the queue stayed empty until the timeout expired.
+ */
+int32_t queue_receive_timeout(message_queue_t *q, message_t *message,
+			      uint32_t timeout);
+
+/**
+ * @brief Receives up to `max` messages in one critical section.
+ *
+ * The messages are copied out in at most two contiguous runs, and every
+ * sender waiting on the full queue is woken once as its message takes one of
+ * the freed slots. This is a non-blocking call, equivalent to
+ * queue_receive_many_timeout() with TUSK_NO_WAIT.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param messages Where to store the received messages, oldest first.
+ * @param max The most messages to receive.
+ * @return The number of messages received.
+ */
+uint32_t queue_receive_many(message_queue_t *q, message_t *messages,
+			    uint32_t max);
+
+/**
+ * @brief Receives up to `max` messages, waiting for the first one if the queue is empty.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param messages Where to store the received messages, oldest first.
+ * @param max The most messages to receive.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return The number of messages received, 0 if the timeout expired.
+ */
+uint32_t queue_receive_many_timeout(message_queue_t *q, message_t *messages,
+				    uint32_t max, uint32_t timeout);
+
+/**
+ * @brief Receives a message from an interrupt handler without blocking.
+ *
+ * @param q Pointer to the `message_queue_t` structure.
+ * @param message Pointer to a `message_t` variable where the received message pointer will be stored.
+ * @return `0` on success.
+ * @return `-1` if the queue is empty.
+ */
+int32_t queue_receive_from_isr(message_queue_t *q, message_t *message);
+
 #endif // M_QUEUE_H_
@@ -3,7 +3,15 @@
  * @brief Interface for Tusk RTOS memory allocator.
  * @author Dimitrios Papakonstantinou
  *
- * A fixed-block memory pool for deterministic allocation times (O(1))
+ * A fixed-block memory pool for deterministic allocation times (O(1)), a
+ * size-class allocator built on top of it, and a TLSF heap for variable-size
+ * blocks with the same bounded allocation times.
+ *
+ * By default the free list is lock-free: allocation and release pop and push
+ * its head with a single compare-and-swap, so both are safe from interrupt
+ * handlers and never block. Set TUSK_MEM_POOL_LOCK_FREE to 0 to protect the
+ * pool with a mutex instead. Either way, tasks that share a pool can put a
+ * mem_pool_cache_t in front of it to batch their traffic to the pool.
 */
 
 #ifndef MEM_H_
@@ -14,17 +22,45 @@
 #include <stdbool.h>
 #include "sync.h"
 
+/**
+ * @def TUSK_MEM_POOL_LOCK_FREE
+ * @brief Set to 1 for lock-free, interrupt-safe pools, or 0 for mutex-protected ones.
+ *
+ * Pools used to be mutex-protected, and now default to lock-free. A
+ * lock-free pool holds at most MEM_POOL_MAX_BLOCKS blocks, and does not
+ * lend a blocked task's priority to anybody because nobody ever blocks.
+ * Set this to 0 to keep the old behaviour, e.g. for larger pools.
+ */
+#ifndef TUSK_MEM_POOL_LOCK_FREE
+#define TUSK_MEM_POOL_LOCK_FREE 1
+#endif
+
+/**
+ * @def MEM_POOL_MAX_BLOCKS
+ * @brief The most blocks a lock-free pool can manage; any excess buffer is left unused.
+ */
+#define MEM_POOL_MAX_BLOCKS 0xFFFFU
+
 /**
  * @brief Memory Pool Control Block
  *        Holds all metadata for a memory pool instance.
  */
 typedef struct {
 	uint8_t *pool_start; // Pointer to the beginning of the underlying memory buffer
+#if TUSK_MEM_POOL_LOCK_FREE
+	// Head of the free-list: a change counter in the upper 16 bits and the
+	// index of the first free block plus one (0 when empty) in the lower 16
+	volatile uint32_t free_head;
+#else
 	void **next_free_block; // Pointer to the head of the free-list
+#endif
 	size_t num_blocks; // Total number of blocks in the pool
 	size_t block_size; // Size of each individual block in bytes
-	size_t used_blocks; // Number of blocks currently allocated (for stats)
+	volatile uint32_t used_blocks; // Number of blocks currently allocated (for stats)
+	volatile uint32_t peak_blocks; // Highest number of blocks ever allocated at once
+#if !TUSK_MEM_POOL_LOCK_FREE
 	tusk_mutex_t mutex; // Mutex for thread-safe access
+#endif
 } mem_pool_t;
 
 /**
@@ -46,7 +82,9 @@ bool mem_pool_init(mem_pool_t *pool, void *pool_buffer, size_t pool_size,
 /**
  * @brief Allocates a memory block from the pool.
  *
- * This function is thread-safe. It will block if the associated mutex is currently held.
+ * This function is thread-safe. A lock-free pool may also be used from
+ * interrupt handlers; otherwise it will block if the associated mutex is
+ * currently held.
  *
  * @param pool Pointer to the initialized memory pool.
  * @return A pointer to an allocated memory block, or NULL if no blocks are available.
@@ -56,7 +94,7 @@ void *mem_pool_alloc(mem_pool_t *pool);
 /**
  * @brief Frees a previously allocated memory block, returning it to the pool.
  *
- * This function is thread-safe.
+ * This function is thread-safe, and interrupt-safe for a lock-free pool.
  *
  * @param pool Pointer to the initialized memory pool.
  * @param block Pointer to the memory block to be freed. The block must have been
@@ -66,7 +104,7 @@ void *mem_pool_alloc(mem_pool_t *pool);
 void mem_pool_free(mem_pool_t *pool, void *block);
 
 /**
- * @brief Deinitializes a memory pool and destroys the associated mutex.
+ * @brief Deinitializes a memory pool and, for a mutex-protected pool, its mutex.
  *
  * @param pool Pointer to the memory pool to deinitialize.
  */
@@ -80,4 +118,357 @@ void mem_pool_deinit(mem_pool_t *pool);
  */
 size_t mem_pool_get_used_count(mem_pool_t *pool);
 
+/**
+ * @brief Gets the highest number of blocks that were ever in use at the same time.
+ *
+ * @param pool Pointer to the memory pool.
+ * @return The peak number of allocated blocks since the pool was initialized.
+ */
+size_t mem_pool_get_peak_count(mem_pool_t *pool);
+
+/**
+ * @brief Allocates up to `count` blocks from the pool at once.
+ *
+ * Like calling mem_pool_alloc() `count` times, but a mutex-protected pool is
+ * locked only once, and the usage counters of a lock-free pool are updated
+ * once for the whole batch.
+ *
+ * @param pool Pointer to the memory pool.
+ * @param blocks An array that receives the blocks.
+ * @param count The number of blocks wanted.
+ * @return The number of blocks allocated, fewer than `count` if the pool ran out.
+ */
+size_t mem_pool_alloc_many(mem_pool_t *pool, void **blocks, size_t count);
+
+/**
+ * @brief Returns `count` blocks to the pool at once.
+ *
+ * Like calling mem_pool_free() for each block, but a mutex-protected pool
+ * is locked only once, and a lock-free pool takes the whole batch with a
+ * single compare-and-swap.
+ *
+ * @param pool Pointer to the memory pool the blocks belong to.
+ * @param blocks The blocks to free.
+ * @param count The number of blocks.
+ */
+void mem_pool_free_many(mem_pool_t *pool, void *const *blocks, size_t count);
+
+// --- Per-Task Pool Caches ---
+
+/**
+ * @def TUSK_MEM_POOL_CACHE_SIZE
+ * @brief The number of free blocks a mem_pool_cache_t can hold.
+ */
+#ifndef TUSK_MEM_POOL_CACHE_SIZE
+#define TUSK_MEM_POOL_CACHE_SIZE 8
+#endif
+
+/**
+ * @def TUSK_MEM_POOL_CACHE_BATCH
+ * @brief The number of blocks a cache takes from or gives back to its pool at a time.
+ */
+#ifndef TUSK_MEM_POOL_CACHE_BATCH
+#define TUSK_MEM_POOL_CACHE_BATCH (TUSK_MEM_POOL_CACHE_SIZE / 2)
+#endif
+
+/**
+ * @brief A task's private cache of free blocks of one pool.
+ *
+ * Blocks in the cache count as used in the pool's statistics.
+ */
+typedef struct mem_pool_cache {
+	mem_pool_t *pool; // The pool the cached blocks belong to
+	struct tcb *owner; // The task using the cache
+	struct mem_pool_cache *next; // Next cache of the same task
+	size_t count; // Number of blocks in the cache
+	volatile uint8_t busy; // Set while the owner is inside a cache operation
+	void *blocks[TUSK_MEM_POOL_CACHE_SIZE]; // The cached blocks, most recent last
+} mem_pool_cache_t;
+
+/**
+ * @brief Sets up a cache of `pool` for the calling task.
+ *
+ * Allocations and releases through the cache only touch the pool once per
+ * TUSK_MEM_POOL_CACHE_BATCH blocks, which takes most of the pressure off a
+ * pool that several tasks share. Only the calling task may use the cache.
+ * It is registered with the task, so the cache must stay valid until the
+ * task is deleted or mem_pool_cache_deinit() is called. Deleting the task
+ * flushes its caches, except one that another task's tusk_delete_task()
+ * caught in the middle of an operation: that one is only detached, and its
+ * blocks stay in it until mem_pool_cache_flush() or mem_pool_cache_deinit()
+ * is called on it.
+ *
+ * @param cache Pointer to the cache structure to initialize.
+ * @param pool Pointer to the memory pool to cache.
+ * @return true on success, false if an argument is invalid or there is no calling task.
+ */
+bool mem_pool_cache_init(mem_pool_cache_t *cache, mem_pool_t *pool);
+
+/**
+ * @brief Flushes a cache and unregisters it from its task, if it still has one.
+ *
+ * @param cache Pointer to the cache.
+ */
+void mem_pool_cache_deinit(mem_pool_cache_t *cache);
+
+/**
+ * @brief Allocates a block, from the cache if it has one.
+ *
+ * An empty cache is first refilled with a batch of blocks from the pool.
+ *
+ * @param cache Pointer to the calling task's cache.
+ * @return A pointer to the block, or NULL if the cache and the pool are both empty.
+ */
+void *mem_pool_cache_alloc(mem_pool_cache_t *cache);
+
+/**
+ * @brief Frees a block into the cache.
+ *
+ * A full cache first gives a batch of blocks back to the pool. The block
+ * may have been allocated by any task, as long as it belongs to the
+ * cache's pool.
+ *
+ * @param cache Pointer to the calling task's cache.
+ * @param block The block to free.
+ */
+void mem_pool_cache_free(mem_pool_cache_t *cache, void *block);
+
+/**
+ * @brief Returns every block in the cache to its pool.
+ *
+ * @param cache Pointer to the cache.
+ */
+void mem_pool_cache_flush(mem_pool_cache_t *cache);
+
+// --- Size-Class Allocator ---
+
+/**
+ * @def TUSK_SLAB_MAX_CLASSES
+ * @brief The most size classes tusk_malloc() can be configured with.
+ */
+#ifndef TUSK_SLAB_MAX_CLASSES
+#define TUSK_SLAB_MAX_CLASSES 8
+#endif
+
+/**
+ * @def TUSK_SLAB_MAX_SIZE
+ * @brief The largest request tusk_malloc() can serve. Sizes the class lookup table.
+ */
+#ifndef TUSK_SLAB_MAX_SIZE
+#define TUSK_SLAB_MAX_SIZE 1024
+#endif
+
+/**
+ * @def TUSK_SLAB_GRANULE
+ * @brief The request size step of the class lookup table, in bytes.
+ */
+#define TUSK_SLAB_GRANULE 8
+
+/**
+ * @brief Describes one size class of tusk_malloc(): its block size and storage.
+ */
+typedef struct {
+	size_t block_size; // Size of every block of this class in bytes
+	void *buffer; // Storage for the blocks
+	size_t buffer_size; // Size of the storage in bytes
+} tusk_slab_class_t;
+
+/**
+ * @brief Usage statistics of one size class.
+ */
+typedef struct {
+	size_t block_size; // Size of every block of this class in bytes
+	size_t num_blocks; // Number of blocks of this class
+	size_t used_blocks; // Number of blocks currently allocated
+	size_t peak_blocks; // Highest number of blocks ever allocated at once
+	uint32_t allocations; // Number of requests served by this class
+	uint32_t failures; // Number of requests for this class that found it empty
+} tusk_slab_stats_t;
+
+/**
+ * @brief Sets up tusk_malloc() with a set of size classes.
+ *
+ * Each class is a fixed-block pool over the storage it describes, and any
+ * request up to TUSK_SLAB_MAX_SIZE bytes is served from the smallest class
+ * that fits it. Classes may be given in any order, but no two may have the
+ * same block size. Must be called before any other tusk_malloc() function,
+ * and not while blocks are allocated.
+ *
+ * @param classes The size classes.
+ * @param count The number of classes, at most TUSK_SLAB_MAX_CLASSES.
+ * @return true on success, false if a class is invalid or there are too many.
+ */
+bool tusk_slab_init(const tusk_slab_class_t *classes, size_t count);
+
+/**
+ * @brief Allocates at least `size` bytes.
+ *
+ * The smallest class that fits is found with one table lookup. If it is
+ * exhausted, the next larger classes are tried, so the time taken is bounded
+ * by the number of classes. Thread-safe, and interrupt-safe with lock-free
+ * pools.
+ *
+ * @param size The number of bytes needed.
+ * @return A pointer to the block, or NULL if no class that fits has a free block.
+ */
+void *tusk_malloc(size_t size);
+
+/**
+ * @brief Returns a block from tusk_malloc() to its class.
+ *
+ * The class is found from the address of the block, so blocks carry no
+ * header.
+ *
+ * @param block The block to free. NULL is ignored.
+ */
+void tusk_free(void *block);
+
+/**
+ * @brief Reports the statistics of every size class, smallest first.
+ *
+ * @param stats An array to fill.
+ * @param max_entries The length of `stats`.
+ * @return The number of entries filled in.
+ */
+size_t tusk_slab_get_stats(tusk_slab_stats_t *stats, size_t max_entries);
+
+// --- TLSF Heap ---
+
+/**
+ * @def TUSK_HEAP_SL_LOG2
+ * @brief log2 of the number of free lists each power-of-two size range is split into.
+ *
+ * More lists waste less memory per allocation but make the heap control
+ * block larger. At most 5.
+ */
+#ifndef TUSK_HEAP_SL_LOG2
+#define TUSK_HEAP_SL_LOG2 4
+#endif
+
+/**
+ * @def TUSK_HEAP_MAX_BLOCK_LOG2
+ * @brief log2 of the size limit of a single heap block. Any larger region is left partly unused.
+ */
+#ifndef TUSK_HEAP_MAX_BLOCK_LOG2
+#define TUSK_HEAP_MAX_BLOCK_LOG2 20
+#endif
+
+/**
+ * @def TUSK_HEAP_ALIGNMENT
+ * @brief The alignment of every block returned by tusk_heap_malloc(), in bytes.
+ */
+#define TUSK_HEAP_ALIGNMENT 8
+
+// Smallest request served by the first level above zero
+#define TUSK_HEAP_FL_SHIFT (TUSK_HEAP_SL_LOG2 + 3)
+#define TUSK_HEAP_FL_COUNT (TUSK_HEAP_MAX_BLOCK_LOG2 - TUSK_HEAP_FL_SHIFT + 1)
+#define TUSK_HEAP_SL_COUNT (1U << TUSK_HEAP_SL_LOG2)
+
+struct tusk_heap_block;
+
+/**
+ * @brief TLSF Heap Control Block
+ *        Holds the segregated free lists and statistics of a heap instance.
+ */
+typedef struct {
+	// Free lists by first-level (power of two) and second-level size range
+	struct tusk_heap_block *free_lists[TUSK_HEAP_FL_COUNT][TUSK_HEAP_SL_COUNT];
+	uint32_t fl_bitmap; // Bit f is set if any list of first level f is non-empty
+	uint32_t sl_bitmap[TUSK_HEAP_FL_COUNT]; // Bit s of entry f is set if list [f][s] is non-empty
+	size_t total_bytes; // Size of the managed part of the region
+	size_t used_bytes; // Payload bytes of allocated blocks
+	size_t peak_used_bytes; // Highest value used_bytes has reached
+	size_t free_bytes; // Payload bytes of free blocks
+	uint32_t used_blocks; // Number of allocated blocks
+	uint32_t free_blocks; // Number of free blocks
+	uint32_t allocations; // Number of successful allocations
+	uint32_t failures; // Number of allocations that found no block
+	tusk_mutex_t mutex; // Mutex for thread-safe access
+} tusk_heap_t;
+
+/**
+ * @brief Heap usage and fragmentation statistics.
+ */
+typedef struct {
+	size_t total_bytes; // Size of the managed part of the region
+	size_t used_bytes; // Payload bytes of allocated blocks
+	size_t peak_used_bytes; // Highest value used_bytes has reached
+	size_t free_bytes; // Payload bytes of free blocks
+	size_t largest_free_block; // Largest request that can currently succeed
+	uint32_t used_blocks; // Number of allocated blocks
+	uint32_t free_blocks; // Number of free blocks
+	uint32_t allocations; // Number of successful allocations
+	uint32_t failures; // Number of allocations that found no block
+	uint8_t fragmentation; // Percentage of free bytes outside the largest free block
+} tusk_heap_stats_t;
+
+/**
+ * @brief Initializes a Two-Level Segregated Fit heap over a memory region.
+ *
+ * Free blocks are kept on size-segregated lists indexed by two bitmaps, so
+ * allocation and release take constant time whatever the state of the
+ * heap, and a freed block is merged with its free neighbours at once. Every
+ * block carries a small header of two pointers.
+ *
+ * @param heap Pointer to the heap structure to initialize.
+ * @param region The memory the heap hands out.
+ * @param region_size The size of the region in bytes.
+ *
+ * @return true if initialization was successful, false if the region is too small.
+ */
+bool tusk_heap_init(tusk_heap_t *heap, void *region, size_t region_size);
+
+/**
+ * @brief Allocates at least `size` bytes from a heap, aligned to TUSK_HEAP_ALIGNMENT.
+ *
+ * Takes constant time. This function is thread-safe; it will block if the
+ * heap is in use by another task, so it must not be called from an
+ * interrupt handler.
+ *
+ * @param heap Pointer to the heap.
+ * @param size The number of bytes needed.
+ * @return A pointer to the block, or NULL if no free block is large enough.
+ */
+void *tusk_heap_malloc(tusk_heap_t *heap, size_t size);
+
+/**
+ * @brief Allocates at least `size` bytes from a heap at a multiple of `alignment`.
+ *
+ * Takes constant time. The space skipped to reach the alignment goes back
+ * to the heap as a free block, which needs room for a block header and the
+ * free-list links. So the request only succeeds if there is a free block of
+ * at least `size` (rounded up to TUSK_HEAP_ALIGNMENT) + `alignment` +
+ * 4 * sizeof(void *) bytes, i.e. `size` + `alignment` + 16 on a 32-bit
+ * target. Like tusk_heap_malloc(), the search also rounds this up to the
+ * next free-list boundary, which adds up to 1 / 2^TUSK_HEAP_SL_LOG2 of it.
+ *
+ * @param heap Pointer to the heap.
+ * @param size The number of bytes needed.
+ * @param alignment The required alignment, a power of two.
+ * @return A pointer to the block, or NULL if `alignment` is invalid or no free block is large enough.
+ */
+void *tusk_heap_malloc_aligned(tusk_heap_t *heap, size_t size,
+			       size_t alignment);
+
+/**
+ * @brief Returns a block to its heap, merging it with any free neighbour.
+ *
+ * Takes constant time. This function is thread-safe.
+ *
+ * @param heap Pointer to the heap the block was allocated from.
+ * @param block The block to free. NULL is ignored.
+ */
+void tusk_heap_free(tusk_heap_t *heap, void *block);
+
+/**
+ * @brief Reports the usage and fragmentation of a heap.
+ *
+ * Finding the largest free block walks one free list, so unlike the
+ * allocation functions this one is not bounded in time.
+ *
+ * @param heap Pointer to the heap.
+ * @param stats The structure to fill.
+ */
+void tusk_heap_get_stats(tusk_heap_t *heap, tusk_heap_stats_t *stats);
+
 #endif // MEM_H_
@@ -0,0 +1,125 @@
+/**
+ * @file msgbuf.h
+ * @brief Reference-counted message buffers carried through message queues.
+ * @author Dimitrios Papakonstantinou
+ *
+ * A message buffer is a block of a mem_pool_t with a small header in front
+ * of its payload. The header remembers the pool the block came from and
+ * counts the references to it, so the block goes back to the right pool as
+ * soon as the last holder lets go of it.
+ *
+ * Sending a buffer through a message_queue_t hands one reference over to
+ * the receiver without copying the payload. To give the same payload to
+ * several consumers, take an extra reference for each of them, or use
+ * tusk_msgbuf_broadcast().
+ */
+
+#ifndef MSGBUF_H_
+#define MSGBUF_H_
+
+#include <stdint.h>
+#include "mem.h"
+#include "m_queue.h"
+
+/**
+ * @struct tusk_msgbuf_t
+ * @brief The header in front of the payload of a message buffer.
+ */
+typedef struct {
+	/**
+     * @var pool
+     * @brief The pool the buffer is returned to.
+     */
+	mem_pool_t *pool;
+
+	/**
+     * @var refs
+     * @brief The number of holders of the buffer.
+     */
+	volatile uint32_t refs;
+
+	/**
+     * @var length
+     * @brief The number of payload bytes in use, maintained by the application.
+     */
+	uint32_t length;
+} tusk_msgbuf_t;
+
+/**
+ * @brief Allocates a buffer from `pool` with a single reference.
+ *
+ * The pool's blocks must be larger than the tusk_msgbuf_t header.
+ *
+ * @param pool The pool to allocate from.
+ * @return The new buffer, or NULL if the pool is exhausted or its blocks are too small.
+ */
+tusk_msgbuf_t *tusk_msgbuf_alloc(mem_pool_t *pool);
+
+/**
+ * @brief Returns the payload of a buffer.
+ */
+static inline void *tusk_msgbuf_data(tusk_msgbuf_t *buf)
+{
+	return buf + 1;
+}
+
+/**
+ * @brief Returns the number of payload bytes a buffer can hold.
+ */
+static inline uint32_t tusk_msgbuf_capacity(const tusk_msgbuf_t *buf)
+{
+	return (uint32_t)(buf->pool->block_size - sizeof(tusk_msgbuf_t));
+}
+
+/**
+ * @brief Adds a reference to a buffer.
+ *
+ * Only a current holder may add references. Safe from interrupt handlers.
+ *
+ * @param buf The buffer.
+ * @return `buf`, for convenience.
+ */
+tusk_msgbuf_t *tusk_msgbuf_ref(tusk_msgbuf_t *buf);
+
+/**
+ * @brief Drops a reference, returning the buffer to its pool if it was the last one.
+ *
+ * @param buf The buffer. Must not be used by the caller afterwards.
+ */
+void tusk_msgbuf_unref(tusk_msgbuf_t *buf);
+
+/**
+ * @brief Sends a buffer, handing the caller's reference to the receiver.
+ *
+ * @param q The queue to send to.
+ * @param buf The buffer to send.
+ * @param timeout The number of ticks to wait for room, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return 0 on success, -1 if the queue stayed full. On failure the caller keeps its reference.
+ */
+int tusk_msgbuf_send(message_queue_t *q, tusk_msgbuf_t *buf, uint32_t timeout);
+
+/**
+ * @brief Receives a buffer together with the reference its sender handed over.
+ *
+ * @param q The queue to receive from.
+ * @param timeout The number of ticks to wait for a buffer, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return The buffer, or NULL if the queue stayed empty. Release it with tusk_msgbuf_unref().
+ */
+tusk_msgbuf_t *tusk_msgbuf_receive(message_queue_t *q, uint32_t timeout);
+
+/**
+ * @brief Sends the same buffer to several queues without copying it.
+ *
+ * Each queue that accepts the buffer gets a reference of its own. The
+ * caller keeps its reference either way.
+ *
+ * @param queues The queues to send to.
+ * @param count The number of queues.
+ * @param buf The buffer to send.
+ * @param timeout The number of ticks to wait for room in each queue.
+ * @return The number of queues the buffer was delivered to.
+ */
+uint32_t tusk_msgbuf_broadcast(message_queue_t *const *queues, uint32_t count,
+			       tusk_msgbuf_t *buf, uint32_t timeout);
+
+#endif // MSGBUF_H_
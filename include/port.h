@@ -0,0 +1,114 @@
+/**
+ * @file port.h
+ * @brief Interface between the portable Tusk RTOS kernel and the target it runs on.
+ * @author Dimitrios Papakonstantinou
+ *
+ * The kernel never touches the CPU directly. Everything that depends on the
+ * target (masking interrupts, requesting a context switch, laying out a new
+ * task's stack, starting the first task and generating the tick) goes
+ * through the functions below. Each port lives in its own directory under
+ * port/ and supplies a portmacro.h with the primitives that have to be
+ * inlined, plus the out-of-line functions declared here.
+ *
+ * Available ports:
+ * - port/cortex-m4: the real target, using BASEPRI, PendSV, SVC and SysTick.
+ * - port/host: a Linux simulation built with `make host`, using ucontext for
+ *   task switching and a SIGALRM interval timer as the tick.
+ *
+ * Every port must provide, in portmacro.h:
+ * - port_disable_interrupts() / port_enable_interrupts(): mask and unmask the
+ *   tick and any other interrupt that may call into the kernel. Calls nest;
+ *   only the outermost port_enable_interrupts() unmasks. Interrupts that
+ *   never call the kernel should stay unmasked where the target allows it.
+ * - port_set_interrupt_mask_from_isr() / port_clear_interrupt_mask_from_isr():
+ *   mask the same interrupts from a handler or a critical section, returning
+ *   and restoring the previous mask so the pair may be nested. Only the
+ *   *_from_isr kernel functions may be called inside such a section.
+ * - port_trigger_context_switch(): request that the scheduler runs as soon as
+ *   interrupts are enabled and no interrupt handler is active.
+ * - port_clz(): count leading zeros of a 32-bit word, returning 32 for 0.
+ * - port_atomic_add(): add to a word and return its old value, atomically
+ *   with respect to interrupts, without disabling them.
+ * - port_atomic_cas() / port_atomic_cas_ptr(): compare-and-swap a word or a
+ *   pointer-sized value under the same guarantee, returning 1 on success.
+ *   Both atomics order every memory access around them, so they can release
+ *   as well as acquire.
+ * - port_memory_barrier(): order the memory accesses before it against those
+ *   after it, as seen by interrupt handlers and other bus masters.
+ * - port_idle(): called in a loop by the idle task, e.g. to sleep until the
+ *   next interrupt.
+ * - PORT_CYCLES_HZ: the rate at which port_get_cycles() counts.
+ */
+
+#ifndef PORT_H_
+#define PORT_H_
+
+#include <stdint.h>
+#include "tusk.h"
+#include "portmacro.h"
+
+/**
+ * @brief Prepares the initial context of a new task.
+ *
+ * The returned value is stored in the task's `stack_pointer` and handed back
+ * to the port when the task is first switched in. When the task is started
+ * it calls `task_handler`, and if that returns, `task_exit`.
+ *
+ * @param stack_top One past the highest word of the task's stack.
+ * @param task_handler The task entry point.
+ * @param task_exit The function to run when the entry point returns.
+ * @return The initial saved context of the task.
+ */
+uint32_t *port_init_stack(uint32_t *stack_top, void (*task_handler)(void),
+			  void (*task_exit)(void));
+
+/**
+ * @brief Releases any per-task resources the port allocated in port_init_stack().
+ *
+ * Called once a deleted task can no longer be running. Interrupts are disabled.
+ *
+ * @param task The task being released.
+ */
+void port_release_task(tcb_t *task);
+
+/**
+ * @brief Starts the tick and switches to `current_tcb`. Does not return.
+ */
+void port_start_first_task(void);
+
+/**
+ * @brief Returns a free-running timestamp for measuring short intervals.
+ *
+ * Counts at PORT_CYCLES_HZ and wraps around at 2^32, so only differences of
+ * two readings are meaningful.
+ *
+ * @return The current timestamp.
+ */
+uint32_t port_get_cycles(void);
+
+/**
+ * @brief Ends the program with the given status.
+ *
+ * On the host this exits the process. On the target it ends the QEMU session
+ * through semihosting when that is enabled, and halts otherwise.
+ *
+ * @param status The exit status, 0 for success.
+ */
+void port_exit(int status);
+
+/**
+ * @brief The tick interrupt. The port calls it once every system tick.
+ *
+ * It masks interrupts up to the kernel priority itself, so it may run at
+ * the lowest priority like PendSV.
+ */
+void SysTick_Handler(void);
+
+/**
+ * @brief Selects the task to run next by updating `current_tcb`.
+ *
+ * Called by the port's context switch with interrupts disabled.
+ */
+void rtos_scheduler(void);
+
+#endif // PORT_H_
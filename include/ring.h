@@ -0,0 +1,177 @@
+/**
+ * @file ring.h
+ * @brief Lock-free single-producer, single-consumer byte ring.
+ * @author Dimitrios Papakonstantinou
+ *
+ * A ring lets exactly one producer and one consumer, such as an interrupt
+ * handler and a task, exchange bytes without masking interrupts. The
+ * producer only ever writes `head` and the consumer only ever writes `tail`.
+ * Both indices run freely and wrap at 2^32, so the fill level is always
+ * `head - tail` and a power-of-two capacity turns every wrap into a mask.
+ *
+ * Besides single-byte and bulk copies, the ring hands out contiguous spans
+ * of its storage, so data can be produced or consumed in place: ask for a
+ * span, fill or read as much of it as needed, then commit or release that
+ * many bytes.
+ *
+ * None of these functions block. A task that has to wait for data must
+ * combine the ring with a notification or a semaphore.
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdint.h>
+#include "port.h"
+
+/**
+ * @struct tusk_ring_t
+ * @brief A single-producer, single-consumer byte ring.
+ */
+typedef struct {
+	/**
+     * @var buffer
+     * @brief The storage of the ring, `mask + 1` bytes long.
+     */
+	uint8_t *buffer;
+
+	/**
+     * @var mask
+     * @brief The capacity minus one. The capacity is a power of two.
+     */
+	uint32_t mask;
+
+	/**
+     * @var head
+     * @brief The total number of bytes ever written. Only the producer changes it.
+     */
+	volatile uint32_t head;
+
+	/**
+     * @var tail
+     * @brief The total number of bytes ever read. Only the consumer changes it.
+     */
+	volatile uint32_t tail;
+} tusk_ring_t;
+
+/**
+ * @brief Initializes an empty ring over `buffer`.
+ *
+ * @param ring A pointer to the `tusk_ring_t` object to be initialized.
+ * @param buffer The storage of the ring.
+ * @param capacity The size of `buffer` in bytes. Must be a power of two.
+ * @return 0 on success, -1 if the capacity is not a power of two.
+ */
+int tusk_ring_init(tusk_ring_t *ring, uint8_t *buffer, uint32_t capacity);
+
+/**
+ * @brief Returns the number of bytes the consumer can read.
+ */
+static inline uint32_t tusk_ring_count(const tusk_ring_t *ring)
+{
+	return ring->head - ring->tail;
+}
+
+/**
+ * @brief Returns the number of bytes the producer can write.
+ */
+static inline uint32_t tusk_ring_space(const tusk_ring_t *ring)
+{
+	return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+/**
+ * @brief Writes one byte. Producer only.
+ *
+ * @return 0 on success, -1 if the ring is full.
+ */
+static inline int tusk_ring_put(tusk_ring_t *ring, uint8_t byte)
+{
+	uint32_t head = ring->head;
+
+	if (head - ring->tail > ring->mask) {
+		return -1;
+	}
+	ring->buffer[head & ring->mask] = byte;
+	// The byte must be in place before the consumer can see it
+	port_memory_barrier();
+	ring->head = head + 1;
+	return 0;
+}
+
+/**
+ * @brief Reads one byte. Consumer only.
+ *
+ * @return 0 on success, -1 if the ring is empty.
+ */
+static inline int tusk_ring_get(tusk_ring_t *ring, uint8_t *byte)
+{
+	uint32_t tail = ring->tail;
+
+	if (ring->head == tail) {
+		return -1;
+	}
+	// Read the byte only after seeing the index that published it, and
+	// finish reading it before the producer may overwrite it
+	port_memory_barrier();
+	*byte = ring->buffer[tail & ring->mask];
+	port_memory_barrier();
+	ring->tail = tail + 1;
+	return 0;
+}
+
+/**
+ * @brief Writes up to `len` bytes. Producer only.
+ *
+ * @return The number of bytes written, less than `len` if the ring filled up.
+ */
+uint32_t tusk_ring_write(tusk_ring_t *ring, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Reads up to `len` bytes. Consumer only.
+ *
+ * @return The number of bytes read, less than `len` if the ring ran empty.
+ */
+uint32_t tusk_ring_read(tusk_ring_t *ring, uint8_t *data, uint32_t len);
+
+/**
+ * @brief Returns the contiguous free space the producer can fill in place.
+ *
+ * The span ends where the free space or the storage ends, so when it wraps
+ * a second call after tusk_ring_commit() returns the rest. Producer only.
+ *
+ * @param ring A pointer to the ring.
+ * @param span Set to the start of the free space.
+ * @return The length of the span in bytes, 0 if the ring is full.
+ */
+uint32_t tusk_ring_write_span(tusk_ring_t *ring, uint8_t **span);
+
+/**
+ * @brief Publishes `len` bytes written into the span from tusk_ring_write_span().
+ *
+ * @param ring A pointer to the ring.
+ * @param len The number of bytes written. Must not exceed the span length.
+ */
+void tusk_ring_commit(tusk_ring_t *ring, uint32_t len);
+
+/**
+ * @brief Returns the contiguous data the consumer can read in place.
+ *
+ * Like tusk_ring_write_span(), the span stops at the end of the storage.
+ * Consumer only.
+ *
+ * @param ring A pointer to the ring.
+ * @param span Set to the start of the data.
+ * @return The length of the span in bytes, 0 if the ring is empty.
+ */
+uint32_t tusk_ring_read_span(tusk_ring_t *ring, const uint8_t **span);
+
+/**
+ * @brief Frees `len` bytes read from the span from tusk_ring_read_span().
+ *
+ * @param ring A pointer to the ring.
+ * @param len The number of bytes consumed. Must not exceed the span length.
+ */
+void tusk_ring_release(tusk_ring_t *ring, uint32_t len);
+
+#endif // RING_H_
@@ -1,7 +1,10 @@
 #ifndef SERIAL_H_
 #define SERIAL_H_
 
+#include <stdint.h>
+
 void uart_init(void);
 void serial_print(const char *str);
+void serial_print_dec(uint32_t value); // Prints an unsigned decimal number
 
 #endif // SERIAL_H_
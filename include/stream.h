@@ -0,0 +1,217 @@
+/**
+ * @file stream.h
+ * @brief Zero-copy stream and message buffers.
+ * @author Dimitrios Papakonstantinou
+ *
+ * Both buffers are built on a single-producer, single-consumer tusk_ring_t
+ * and hand out pointers into their own storage instead of copying:
+ *
+ * - A writer calls *_reserve() to get room, fills it in place and calls
+ *   *_commit() to publish it.
+ * - A reader calls *_peek() to borrow the oldest data in place and
+ *   *_release() once it is done with it.
+ *
+ * A stream buffer carries a plain byte stream, so a reservation or a peek
+ * may be cut short where the storage wraps around. A message buffer keeps
+ * every message in one contiguous piece behind a length header, skipping
+ * the end of the storage when a message would not fit there.
+ *
+ * One task may block until enough data is available. Writers never block,
+ * and committing is safe from interrupt handlers. As with the ring, there
+ * must be only one writer and one reader at a time.
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+#include "tusk.h"
+#include "ring.h"
+
+/**
+ * @struct tusk_stream_buffer_t
+ * @brief A byte stream with in-place access.
+ */
+typedef struct {
+	/**
+     * @var ring
+     * @brief The ring holding the stream.
+     */
+	tusk_ring_t ring;
+
+	/**
+     * @var trigger
+     * @brief The number of bytes the blocked reader waits for.
+     */
+	uint32_t trigger;
+
+	/**
+     * @var reader
+     * @brief The reader blocked until `trigger` bytes are available, if any.
+     */
+	wait_queue_t reader;
+} tusk_stream_buffer_t;
+
+/**
+ * @struct tusk_message_buffer_t
+ * @brief A queue of variable-length messages, each stored contiguously.
+ */
+typedef struct {
+	/**
+     * @var stream
+     * @brief The underlying stream of length-prefixed records.
+     */
+	tusk_stream_buffer_t stream;
+
+	/**
+     * @var reserved
+     * @brief The bytes the writer skips at the end of the storage for its reservation.
+     */
+	uint32_t reserved;
+
+	/**
+     * @var peeked
+     * @brief The size of the record the reader is looking at.
+     */
+	uint32_t peeked;
+} tusk_message_buffer_t;
+
+// --- Stream Buffers ---
+
+/**
+ * @brief Initializes an empty stream buffer.
+ *
+ * @param stream A pointer to the `tusk_stream_buffer_t` object to be initialized.
+ * @param buffer The storage of the stream.
+ * @param capacity The size of `buffer` in bytes. Must be a power of two.
+ * @return 0 on success, -1 if the capacity is not a power of two.
+ */
+int tusk_stream_init(tusk_stream_buffer_t *stream, uint8_t *buffer,
+		     uint32_t capacity);
+
+/**
+ * @brief Returns the number of bytes the reader can consume.
+ */
+static inline uint32_t tusk_stream_count(const tusk_stream_buffer_t *stream)
+{
+	return tusk_ring_count(&stream->ring);
+}
+
+/**
+ * @brief Reserves up to `len` contiguous bytes for the writer to fill in place.
+ *
+ * Less than `len` is granted if the stream is nearly full or the storage
+ * wraps around first. Nothing becomes visible to the reader before
+ * tusk_stream_commit().
+ *
+ * @param stream A pointer to the stream buffer.
+ * @param len The number of bytes wanted.
+ * @param data Set to the start of the reserved bytes.
+ * @return The number of bytes reserved, 0 if the stream is full.
+ */
+uint32_t tusk_stream_reserve(tusk_stream_buffer_t *stream, uint32_t len,
+			     uint8_t **data);
+
+/**
+ * @brief Publishes `len` bytes written into the last reservation.
+ *
+ * Wakes the reader once as many bytes as it waits for are available. May be
+ * called from an interrupt handler.
+ *
+ * @param stream A pointer to the stream buffer.
+ * @param len The number of bytes written. Must not exceed the reservation.
+ */
+void tusk_stream_commit(tusk_stream_buffer_t *stream, uint32_t len);
+
+/**
+ * @brief Borrows the oldest contiguous bytes of the stream.
+ *
+ * @param stream A pointer to the stream buffer.
+ * @param data Set to the start of the bytes.
+ * @return The number of contiguous bytes, 0 if the stream is empty.
+ */
+uint32_t tusk_stream_peek(tusk_stream_buffer_t *stream, const uint8_t **data);
+
+/**
+ * @brief Consumes `len` bytes borrowed with tusk_stream_peek().
+ *
+ * @param stream A pointer to the stream buffer.
+ * @param len The number of bytes consumed. Must not exceed the peeked length.
+ */
+void tusk_stream_release(tusk_stream_buffer_t *stream, uint32_t len);
+
+/**
+ * @brief Waits until at least `len` bytes can be consumed.
+ *
+ * The bytes may still be split across the wrap of the storage, so a reader
+ * that needs them all may have to peek twice.
+ *
+ * @param stream A pointer to the stream buffer.
+ * @param len The number of bytes to wait for, at most the capacity.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return 0 once the bytes are available, -1 on timeout or if `len` exceeds the capacity.
+ */
+int tusk_stream_wait(tusk_stream_buffer_t *stream, uint32_t len,
+		     uint32_t timeout);
+
+// --- Message Buffers ---
+
+/**
+ * @brief Initializes an empty message buffer.
+ *
+ * Every message takes a 4-byte length header plus its payload rounded up to
+ * a multiple of 4 bytes.
+ *
+ * @param messages A pointer to the `tusk_message_buffer_t` object to be initialized.
+ * @param buffer The storage of the buffer. Must be 4-byte aligned.
+ * @param capacity The size of `buffer` in bytes. Must be a power of two of at least 8.
+ * @return 0 on success, -1 if the storage is misaligned or the capacity invalid.
+ */
+int tusk_message_buffer_init(tusk_message_buffer_t *messages, uint8_t *buffer,
+			     uint32_t capacity);
+
+/**
+ * @brief Reserves contiguous room for a message of `len` bytes.
+ *
+ * @param messages A pointer to the message buffer.
+ * @param len The largest payload the writer may store.
+ * @return A 4-byte aligned pointer to the payload, or NULL if the message does not fit.
+ */
+void *tusk_message_reserve(tusk_message_buffer_t *messages, uint32_t len);
+
+/**
+ * @brief Publishes the reserved message with a payload of `len` bytes.
+ *
+ * May be called from an interrupt handler.
+ *
+ * @param messages A pointer to the message buffer.
+ * @param len The payload length. Must not exceed the reserved length.
+ */
+void tusk_message_commit(tusk_message_buffer_t *messages, uint32_t len);
+
+/**
+ * @brief Borrows the oldest message.
+ *
+ * @param messages A pointer to the message buffer.
+ * @param len Set to the payload length.
+ * @return A pointer to the payload, or NULL if there is no message.
+ */
+const void *tusk_message_peek(tusk_message_buffer_t *messages, uint32_t *len);
+
+/**
+ * @brief Consumes the message borrowed with tusk_message_peek().
+ *
+ * @param messages A pointer to the message buffer.
+ */
+void tusk_message_release(tusk_message_buffer_t *messages);
+
+/**
+ * @brief Waits until a message is available.
+ *
+ * @param messages A pointer to the message buffer.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return 0 once a message is available, -1 on timeout.
+ */
+int tusk_message_wait(tusk_message_buffer_t *messages, uint32_t timeout);
+
+#endif // STREAM_H_
@@ -16,15 +16,30 @@
 
 /**
  * @name Mutex States
+ * A held mutex's lock word is the address of the owner's TCB, possibly with
+ * MUTEX_WAITERS set.
  * @{
  */
 /** @def MUTEX_UNLOCKED
- *  @brief A mutex state indicating that the mutex is not currently held and can be acquired. */
-#define MUTEX_UNLOCKED 1
+ *  @brief The lock word of a mutex that is not currently held and can be acquired. */
+#define MUTEX_UNLOCKED 0
 
-/** @def MUTEX_LOCKED
- *  @brief A mutex state indicating that the mutex is currently held by a task. */
-#define MUTEX_LOCKED 0
+/** @def MUTEX_WAITERS
+ *  @brief A lock word bit set while tasks may be waiting, which sends the owner's release down the slow path. */
+#define MUTEX_WAITERS 1
+/** @} */
+
+/**
+ * @name Mutex Protocols
+ * @{
+ */
+/** @def TUSK_MUTEX_INHERIT
+ *  @brief The owner runs at the priority of its most urgent waiter, through chains of nested mutexes. */
+#define TUSK_MUTEX_INHERIT 0
+
+/** @def TUSK_MUTEX_CEILING
+ *  @brief The owner runs at the mutex's ceiling priority from the moment it acquires it. */
+#define TUSK_MUTEX_CEILING 1
 /** @} */
 
 /**
@@ -33,27 +48,57 @@
  *
  * This structure provides a mechanism to ensure that only one task can access a
  * shared resource at a time. Tasks waiting to acquire a locked mutex are
-- * placed in a waiting list and blocked until the mutex is released.
+ * placed in a waiting list, ordered by priority, and blocked until the mutex
+ * is released. The owner's priority is raised according to the mutex
+ * protocol, so a higher-priority task is only ever blocked for as long as
+ * the owner needs the mutex, never by unrelated medium-priority tasks.
+ *
+ * Acquiring a free mutex and releasing one that nobody waits for are done
+ * with an atomic compare-and-swap of the lock word and never mask
+ * interrupts. Only blocking and waking go through the kernel.
  */
-typedef struct {
+typedef struct tusk_mutex {
+	/**
+     * @var lock
+     * @brief MUTEX_UNLOCKED, or the owner's TCB address, possibly with MUTEX_WAITERS set.
+     */
+	volatile uintptr_t lock;
+
+	/**
+     * @var protocol
+     * @brief TUSK_MUTEX_INHERIT or TUSK_MUTEX_CEILING.
+     */
+	uint8_t protocol;
+
 	/**
-     * @var locked
-     * @brief The current state of the mutex (MUTEX_LOCKED or MUTEX_UNLOCKED).
+     * @var ceiling
+     * @brief The priority a TUSK_MUTEX_CEILING owner is raised to.
      */
-	volatile uint8_t locked;
+	uint8_t ceiling;
 
 	/**
-     * @var owner
-     * @brief A pointer to the Task Control Block (TCB) of the task that currently holds the mutex.
-     * Is NULL if the mutex is unlocked.
+     * @var recursive
+     * @brief Non-zero if the owner may acquire the mutex again without deadlocking.
      */
-	struct tcb *owner;
+	uint8_t recursive;
+
+	/**
+     * @var depth
+     * @brief How many more times a recursive mutex was acquired by its owner than released.
+     */
+	uint16_t depth;
 
 	/**
      * @var waiting_list
-     * @brief A pointer to the head of a linked list of tasks that are blocked waiting to acquire this mutex.
+     * @brief The tasks that are blocked waiting to acquire this mutex, most urgent first.
      */
-	struct tcb *waiting_list;
+	wait_queue_t waiting_list;
+
+	/**
+     * @var next_held
+     * @brief The next mutex held by the same owner.
+     */
+	struct tusk_mutex *next_held;
 } tusk_mutex_t;
 
 /**
@@ -67,26 +112,120 @@ typedef struct {
 	/**
      * @var count
      * @brief The current count of the semaphore. If the count is positive, a task can
-     * take the semaphore without blocking. If it is zero or negative, the task will block.
+     * take the semaphore without blocking. If it is zero, the task will block. A count
+     * of -1 means no units are left and tasks may be waiting, which sends posts down
+     * the slow path: a post with waiting tasks hands the unit directly to the first
+     * waiter. Taking and giving units without waiters is a lock-free compare-and-swap.
      */
 	volatile int32_t count;
 
 	/**
      * @var waiting_list
-     * @brief A pointer to the head of a linked list of tasks that are blocked waiting for this semaphore.
+     * @brief The tasks that are blocked waiting for this semaphore, most urgent first.
      */
-	struct tcb *waiting_list;
+	wait_queue_t waiting_list;
 } rtos_semaphore_t;
 
 /**
- * @brief Initializes a mutex.
+ * @struct tusk_event_group_t
+ * @brief A word of 32 event flags that tasks can wait on.
+ *
+ * Tasks wait for any or all of a set of flags to become set. Setting flags
+ * checks every waiter in a single pass and wakes all whose condition is met.
+ */
+typedef struct {
+	/**
+     * @var flags
+     * @brief The current event flags.
+     */
+	volatile uint32_t flags;
+
+	/**
+     * @var waiting_list
+     * @brief The tasks that are blocked waiting for flags, most urgent first.
+     */
+	wait_queue_t waiting_list;
+} tusk_event_group_t;
+
+/**
+ * @name Event Group Wait Modes
+ * @{
+ */
+/** @def TUSK_EVENT_WAIT_ANY
+ *  @brief tusk_event_wait() returns once any of the requested flags is set. */
+#define TUSK_EVENT_WAIT_ANY 0
+
+/** @def TUSK_EVENT_WAIT_ALL
+ *  @brief tusk_event_wait() returns once all of the requested flags are set. */
+#define TUSK_EVENT_WAIT_ALL 1
+/** @} */
+
+/**
+ * @name Notification Actions
+ * How tusk_notify() updates the target task's notification word.
+ * @{
+ */
+/** @def TUSK_NOTIFY_SET_BITS
+ *  @brief ORs the value into the notification word, like a private event group. */
+#define TUSK_NOTIFY_SET_BITS 0
+
+/** @def TUSK_NOTIFY_INCREMENT
+ *  @brief Increments the notification word and ignores the value, like a private counting semaphore. */
+#define TUSK_NOTIFY_INCREMENT 1
+
+/** @def TUSK_NOTIFY_OVERWRITE
+ *  @brief Replaces the notification word with the value, like a one-entry mailbox. */
+#define TUSK_NOTIFY_OVERWRITE 2
+/** @} */
+
+/**
+ * @brief Initializes a priority-inheritance mutex.
  *
  * This function sets the mutex to its initial unlocked state, ready for use.
+ * While a task waits for the mutex, the owner inherits the waiter's priority
+ * if it is higher. The boost follows the chain when the owner itself waits
+ * for another mutex, and is dropped as soon as the mutex is released.
  *
  * @param mutex A pointer to the `tusk_mutex_t` object to be initialized.
  */
 void tusk_mutex_init(tusk_mutex_t *mutex);
 
+/**
+ * @brief Initializes an immediate priority-ceiling mutex.
+ *
+ * Whoever acquires the mutex runs at `ceiling` until it releases it, so no
+ * other task that uses the mutex can preempt the owner and a task blocks on
+ * it at most once. `ceiling` should be the priority of the most urgent task
+ * that ever acquires the mutex.
+ *
+ * @param mutex A pointer to the `tusk_mutex_t` object to be initialized.
+ * @param ceiling The ceiling priority, below TUSK_MAX_PRIORITIES.
+ * @return int 0 on success, or a negative value if the ceiling is invalid.
+ */
+int tusk_mutex_init_ceiling(tusk_mutex_t *mutex, uint8_t ceiling);
+
+/**
+ * @brief Initializes a recursive priority-inheritance mutex.
+ *
+ * The owner may acquire the mutex again while it holds it, which is useful
+ * for functions that lock a resource and may call each other. The mutex is
+ * only released once every acquire has been matched by a release.
+ *
+ * @param mutex A pointer to the `tusk_mutex_t` object to be initialized.
+ */
+void tusk_mutex_init_recursive(tusk_mutex_t *mutex);
+
+/**
+ * @brief Returns the task that holds a mutex.
+ *
+ * @param mutex A pointer to the `tusk_mutex_t` object.
+ * @return The owner's TCB, or NULL if the mutex is free.
+ */
+static inline struct tcb *tusk_mutex_owner(const tusk_mutex_t *mutex)
+{
+	return (struct tcb *)(mutex->lock & ~(uintptr_t)MUTEX_WAITERS);
+}
+
 /**
  * @brief Acquires a mutex.
  *
@@ -98,11 +237,26 @@ void tusk_mutex_init(tusk_mutex_t *mutex);
  */
 void tusk_mutex_acquire(tusk_mutex_t *mutex);
 
+/**
+ * @brief Acquires a mutex, waiting at most `timeout` ticks for it.
+ *
+ * Like tusk_mutex_acquire(), but gives up once the timeout expires. A task
+ * that gives up no longer lends its priority to the owner.
+ *
+ * @param mutex A pointer to the `tusk_mutex_t` object to be acquired.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return int 0 if the mutex was acquired, or a negative value on timeout.
+ */
+int tusk_mutex_acquire_timeout(tusk_mutex_t *mutex, uint32_t timeout);
+
 /**
  * @brief Releases a mutex.
  *
  * The mutex is unlocked. If there are tasks waiting to acquire the mutex,
- * the highest-priority waiting task is unblocked and given the mutex.
+ * the highest-priority waiting task is unblocked and given the mutex. The
+ * caller drops back to the highest priority still required by the mutexes
+ * it holds, which may switch to the woken task right away. Mutexes may be
+ * released in any order.
  *
  * @param mutex A pointer to the `tusk_mutex_t` object to be released.
  *              The mutex must be owned by the calling task.
@@ -130,6 +284,17 @@ void tusk_semaphore_init(rtos_semaphore_t *semaphore, int32_t initial_count);
  */
 void tusk_semaphore_wait(rtos_semaphore_t *semaphore);
 
+/**
+ * @brief Waits for a semaphore for at most `timeout` ticks.
+ *
+ * Like tusk_semaphore_wait(), but gives up once the timeout expires.
+ *
+ * @param semaphore A pointer to the `rtos_semaphore_t` object.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return int 0 if a unit was taken, or a negative value on timeout.
+ */
+int tusk_semaphore_wait_timeout(rtos_semaphore_t *semaphore, uint32_t timeout);
+
 /**
  * @brief Posts to (or increments) a semaphore.
  *
@@ -141,4 +306,112 @@ void tusk_semaphore_wait(rtos_semaphore_t *semaphore);
  */
 void tusk_semaphore_post(rtos_semaphore_t *semaphore);
 
+/**
+ * @brief Initializes an event group with all flags cleared.
+ *
+ * @param group A pointer to the `tusk_event_group_t` object to be initialized.
+ */
+void tusk_event_init(tusk_event_group_t *group);
+
+/**
+ * @brief Sets event flags and wakes every task whose wait condition is now met.
+ *
+ * All waiters are checked against the same flag value in one pass, and the
+ * flags of waiters that asked for clear-on-exit are cleared after the pass,
+ * so one call can release several tasks waiting on the same flag.
+ *
+ * @param group A pointer to the `tusk_event_group_t` object.
+ * @param bits The flags to set.
+ * @return The flags after setting `bits` and before any clear-on-exit.
+ */
+uint32_t tusk_event_set(tusk_event_group_t *group, uint32_t bits);
+
+/**
+ * @brief Sets event flags from an interrupt handler.
+ *
+ * Behaves like tusk_event_set(), but saves and restores the interrupt mask
+ * instead of unmasking interrupts on exit. The handler runs for as long as
+ * it takes to check every waiter, so keep the number of waiters small.
+ *
+ * @param group A pointer to the `tusk_event_group_t` object.
+ * @param bits The flags to set.
+ * @return The flags after setting `bits` and before any clear-on-exit.
+ */
+uint32_t tusk_event_set_from_isr(tusk_event_group_t *group, uint32_t bits);
+
+/**
+ * @brief Clears event flags.
+ *
+ * @param group A pointer to the `tusk_event_group_t` object.
+ * @param bits The flags to clear.
+ * @return The flags before they were cleared.
+ */
+uint32_t tusk_event_clear(tusk_event_group_t *group, uint32_t bits);
+
+/**
+ * @brief Waits for any or all of a set of event flags.
+ *
+ * Returns at once if the condition already holds. Otherwise the task blocks
+ * until tusk_event_set() meets it or the timeout expires.
+ *
+ * @param group A pointer to the `tusk_event_group_t` object.
+ * @param mask The flags to wait for. Must not be 0.
+ * @param wait_mode TUSK_EVENT_WAIT_ANY or TUSK_EVENT_WAIT_ALL.
+ * @param clear_on_exit If non-zero, the flags in `mask` are cleared when the
+ *                      condition is met.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return The flags at the moment the condition was met, before clearing, or
+ *         the current flags on timeout. Check the result against `mask` to
+ *         tell the two apart.
+ */
+uint32_t tusk_event_wait(tusk_event_group_t *group, uint32_t mask,
+			 uint8_t wait_mode, uint8_t clear_on_exit,
+			 uint32_t timeout);
+
+/**
+ * @brief Sends a notification to a task.
+ *
+ * Updates the task's notification word according to `action` and marks a
+ * notification as pending. If the task is blocked in tusk_notify_wait() it
+ * is made ready directly, without any wait list or separate kernel object,
+ * which makes this the cheapest way to signal one specific task.
+ *
+ * @param task The task to notify.
+ * @param value The value to apply. Ignored by TUSK_NOTIFY_INCREMENT.
+ * @param action TUSK_NOTIFY_SET_BITS, TUSK_NOTIFY_INCREMENT or TUSK_NOTIFY_OVERWRITE.
+ * @return int 0 on success, or a negative value if the task or action is invalid.
+ */
+int tusk_notify(struct tcb *task, uint32_t value, uint8_t action);
+
+/**
+ * @brief Sends a notification to a task from an interrupt handler.
+ *
+ * Behaves like tusk_notify(), but saves and restores the interrupt mask
+ * instead of unmasking interrupts on exit, so it may be called from any
+ * handler that is allowed to use the kernel. If the woken task is more urgent
+ * than the interrupted one, the switch happens when the handler returns.
+ *
+ * @param task The task to notify.
+ * @param value The value to apply. Ignored by TUSK_NOTIFY_INCREMENT.
+ * @param action TUSK_NOTIFY_SET_BITS, TUSK_NOTIFY_INCREMENT or TUSK_NOTIFY_OVERWRITE.
+ * @return int 0 on success, or a negative value if the task or action is invalid.
+ */
+int tusk_notify_from_isr(struct tcb *task, uint32_t value, uint8_t action);
+
+/**
+ * @brief Waits for a notification to the calling task.
+ *
+ * Returns at once if a notification is already pending. Otherwise the task
+ * blocks until tusk_notify() is called for it or the timeout expires. On
+ * success the notification word is stored in `value`, the bits in
+ * `clear_mask` are cleared and the notification is consumed. Pass 0xFFFFFFFF
+ * to reset the word completely, or 0 to keep accumulating bits.
+ *
+ * @param clear_mask The bits of the notification word to clear after reading it.
+ * @param value Receives the notification word. May be NULL.
+ * @param timeout The number of ticks to wait, TUSK_NO_WAIT or TUSK_WAIT_FOREVER.
+ * @return int 0 if a notification was received, or a negative value on timeout.
+ */
+int tusk_notify_wait(uint32_t clear_mask, uint32_t *value, uint32_t timeout);
+
 #endif // SYNC_H_
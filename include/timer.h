@@ -0,0 +1,180 @@
+/**
+ * @file timer.h
+ * @brief Public interface for Tusk RTOS software timers.
+ * @author Dimitrios Papakonstantinou
+ *
+ * Software timers run a callback once (one-shot) or periodically
+ * (auto-reload) without dedicating a task to each job. All callbacks are
+ * executed by a single timer service task, so they should not block for
+ * long: while one callback waits on a mutex, queue or delay, no other timer
+ * fires. The ticks that pass meanwhile are caught up once it returns.
+ *
+ * Active timers are kept in a hierarchical timing wheel driven by the system
+ * tick. Starting, stopping and expiring a timer are O(1) operations, so the
+ * per-tick cost stays flat no matter how many timers are running.
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+#include "tusk.h"
+
+// --- Configuration ---
+
+/**
+ * @def TUSK_TIMER_TASK_PRIORITY
+ * @brief The priority of the timer service task that executes timer callbacks.
+ */
+#define TUSK_TIMER_TASK_PRIORITY (TUSK_MAX_PRIORITIES - 1)
+
+/**
+ * @def TUSK_TIMER_STACK_SIZE
+ * @brief The size of the timer service task's stack, in words.
+ */
+#define TUSK_TIMER_STACK_SIZE 256
+
+/**
+ * @def TIMER_WHEEL_BITS
+ * @brief Number of tick bits resolved by each level of the timing wheel.
+ *
+ * Each level has (1 << TIMER_WHEEL_BITS) slots. Timers further away than the
+ * wheel can represent are parked in the outermost level and re-cascaded.
+ */
+#define TIMER_WHEEL_BITS 6
+
+/**
+ * @def TIMER_WHEEL_LEVELS
+ * @brief Number of levels in the timing wheel.
+ */
+#define TIMER_WHEEL_LEVELS 4
+
+/**
+ * @name Timer Modes
+ * @{
+ */
+/** @def TUSK_TIMER_ONE_SHOT
+ *  @brief The timer fires once and then stops. */
+#define TUSK_TIMER_ONE_SHOT 0
+
+/** @def TUSK_TIMER_AUTO_RELOAD
+ *  @brief The timer fires every period until it is stopped. */
+#define TUSK_TIMER_AUTO_RELOAD 1
+/** @} */
+
+struct tusk_timer;
+
+/**
+ * @typedef tusk_timer_callback_t
+ * @brief Signature of a timer callback.
+ *
+ * @param timer The timer that expired.
+ * @param arg The user argument given to tusk_timer_create().
+ */
+typedef void (*tusk_timer_callback_t)(struct tusk_timer *timer, void *arg);
+
+/**
+ * @struct tusk_timer_t
+ * @brief A software timer.
+ *
+ * The structure is owned by the caller and must stay valid while the timer
+ * is active. Its fields are managed by the kernel and should not be modified
+ * directly.
+ */
+typedef struct tusk_timer {
+	/**
+     * @var next
+     * @brief Pointer to the next timer in the same wheel slot.
+     */
+	struct tusk_timer *next;
+
+	/**
+     * @var pprev
+     * @brief Pointer to the link that points at this timer, for O(1) removal.
+     * Is NULL while the timer is not active.
+     */
+	struct tusk_timer **pprev;
+
+	/**
+     * @var expiry
+     * @brief The system tick count at which the timer expires.
+     */
+	uint32_t expiry;
+
+	/**
+     * @var period
+     * @brief The timer period in ticks.
+     */
+	uint32_t period;
+
+	/**
+     * @var mode
+     * @brief TUSK_TIMER_ONE_SHOT or TUSK_TIMER_AUTO_RELOAD.
+     */
+	uint8_t mode;
+
+	/**
+     * @var level
+     * @brief The wheel level the timer is currently filed in.
+     */
+	uint8_t level;
+
+	/**
+     * @var callback
+     * @brief The function executed by the timer service when the timer expires.
+     */
+	tusk_timer_callback_t callback;
+
+	/**
+     * @var arg
+     * @brief The user argument passed to the callback.
+     */
+	void *arg;
+} tusk_timer_t;
+
+/**
+ * @brief Initializes a software timer.
+ *
+ * The timer is created in the stopped state.
+ *
+ * @param timer A pointer to the `tusk_timer_t` object to initialize.
+ * @param callback The function to run when the timer expires.
+ * @param arg A user argument passed to the callback.
+ * @param period The timer period in ticks. Must be greater than zero.
+ * @param mode TUSK_TIMER_ONE_SHOT or TUSK_TIMER_AUTO_RELOAD.
+ * @return `0` on success, `-1` on invalid arguments.
+ */
+int tusk_timer_create(tusk_timer_t *timer, tusk_timer_callback_t callback,
+		      void *arg, uint32_t period, uint8_t mode);
+
+/**
+ * @brief Starts (or restarts) a timer.
+ *
+ * The timer will expire `period` ticks from now. Restarting an active timer
+ * pushes its expiry back. Safe to call from tasks, timer callbacks and ISRs.
+ *
+ * @param timer A pointer to the timer.
+ * @return `0` on success, `-1` if the timer is invalid.
+ */
+int tusk_timer_start(tusk_timer_t *timer);
+
+/**
+ * @brief Stops a timer.
+ *
+ * Stopping an inactive timer has no effect. Safe to call from tasks, timer
+ * callbacks and ISRs.
+ *
+ * @param timer A pointer to the timer.
+ * @return `0` on success, `-1` if the timer is invalid.
+ */
+int tusk_timer_stop(tusk_timer_t *timer);
+
+/**
+ * @brief Checks whether a timer is currently running.
+ *
+ * @param timer A pointer to the timer.
+ * @return `1` if the timer is active, `0` otherwise.
+ */
+uint8_t tusk_timer_is_active(const tusk_timer_t *timer);
+
+#endif // TIMER_H_
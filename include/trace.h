@@ -0,0 +1,121 @@
+/**
+ * @file trace.h
+ * @brief Scheduler event trace for Tusk RTOS.
+ * @author Dimitrios Papakonstantinou
+ *
+ * With TUSK_USE_TRACE enabled the kernel records an event every time it
+ * switches tasks, wakes a delayed task, blocks or wakes a task on a mutex,
+ * semaphore or notification, or sends and receives on a message queue.
+ * Events are 12-byte records (timestamp, event id, task index, argument)
+ * written into a RAM ring buffer. Writers claim a slot with a single atomic
+ * increment and never disable interrupts, so recording costs a few dozen
+ * cycles and tracing can stay enabled in production builds.
+ *
+ * A task calls tusk_trace_drain() periodically to send the buffered events
+ * over the serial port as text lines:
+ *
+ *   @H<hz>                 Header, timestamp rate in Hz (8 hex digits)
+ *   @T<ts><ev><task><arg>  Event (8, 2, 2 and 4 hex digits)
+ *   @L<count>              Events lost to buffer overruns (8 hex digits)
+ *
+ * tools/trace2perfetto.py turns a captured serial log into Chrome/Perfetto
+ * trace JSON that can be opened at https://ui.perfetto.dev.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdint.h>
+#include "tusk.h"
+
+// --- Configuration ---
+
+/**
+ * @def TUSK_USE_TRACE
+ * @brief Set to 1 to record scheduler events. When 0 the trace hooks compile to nothing.
+ */
+#ifndef TUSK_USE_TRACE
+#define TUSK_USE_TRACE 0
+#endif
+
+/**
+ * @def TUSK_TRACE_BUFFER_SIZE
+ * @brief The number of events the ring buffer holds. Must be a power of two.
+ *
+ * When the buffer is not drained in time the oldest events are overwritten
+ * and reported as lost.
+ */
+#ifndef TUSK_TRACE_BUFFER_SIZE
+#define TUSK_TRACE_BUFFER_SIZE 256
+#endif
+
+/**
+ * @name Trace Events
+ * @{
+ */
+/** @brief The scheduler switched to `task`. The argument is the index of the previous task. */
+#define TRACE_TASK_SWITCH 0x01
+/** @brief `task` was created. The argument is its priority. */
+#define TRACE_TASK_CREATE 0x02
+/** @brief `task` was deleted. */
+#define TRACE_TASK_DELETE 0x03
+/** @brief `task` started sleeping. The argument is the delay in ticks. */
+#define TRACE_TASK_DELAY 0x04
+/** @brief The tick handler woke `task` because its delay expired. */
+#define TRACE_DELAY_EXPIRE 0x05
+/** @brief The tick handler rotated the time slice away from `task`. */
+#define TRACE_TIME_SLICE 0x06
+/** @brief The priority of `task` was raised or lowered by a mutex. The argument is the new priority. */
+#define TRACE_PRIORITY_CHANGE 0x07
+/** @brief The timeout of `task` expired while it waited on a mutex, semaphore, event group or queue. */
+#define TRACE_WAIT_TIMEOUT 0x08
+/** @brief `task` blocked on a mutex. The argument identifies the mutex. */
+#define TRACE_MUTEX_BLOCK 0x10
+/** @brief `task` was handed a mutex it was waiting for. */
+#define TRACE_MUTEX_WAKE 0x11
+/** @brief `task` blocked on a semaphore. The argument identifies the semaphore. */
+#define TRACE_SEM_BLOCK 0x12
+/** @brief `task` was handed a semaphore unit it was waiting for. */
+#define TRACE_SEM_WAKE 0x13
+/** @brief `task` blocked waiting for a notification. */
+#define TRACE_NOTIFY_BLOCK 0x14
+/** @brief `task` was woken by a notification. The argument is the notify action. */
+#define TRACE_NOTIFY_WAKE 0x15
+/** @brief `task` blocked on an event group. The argument identifies the group. */
+#define TRACE_EVENT_BLOCK 0x16
+/** @brief `task` was woken because the event flags it waited for were set. */
+#define TRACE_EVENT_WAKE 0x17
+/** @brief `task` sent a message. The argument is the number of queued messages. */
+#define TRACE_QUEUE_SEND 0x20
+/** @brief `task` received a message. The argument is the number of queued messages. */
+#define TRACE_QUEUE_RECEIVE 0x21
+/** @brief `task` tried to send to a full queue, and blocks if it may wait. The argument identifies the queue. */
+#define TRACE_QUEUE_FULL 0x22
+/** @brief `task` tried to receive from an empty queue, and blocks if it may wait. The argument identifies the queue. */
+#define TRACE_QUEUE_EMPTY 0x23
+/** @} */
+
+/**
+ * @name Trace Task Indices
+ * Application tasks are identified by their index in the TCB table.
+ * @{
+ */
+/** @brief The idle task. */
+#define TRACE_TASK_IDLE 0xFF
+/** @brief A kernel service task, such as the timer service. */
+#define TRACE_TASK_KERNEL 0xFE
+/** @} */
+
+#if TUSK_USE_TRACE
+/**
+ * @brief Sends all buffered trace events over the serial port.
+ *
+ * Must only be called from one task at a time. Events recorded while the
+ * drain is running are picked up by the next call.
+ *
+ * @return The number of events sent.
+ */
+uint32_t tusk_trace_drain(void);
+#endif
+
+#endif // TRACE_H_
@@ -12,19 +12,160 @@
 #define TUSK_H
 
 #include <stdint.h>
-#include "core_cm4.h"
+#include <stddef.h>
 
 /**
  * @def MAX_TASKS
  * @brief The maximum number of tasks that can be managed by the scheduler.
  */
-#define MAX_TASKS 5
+#define MAX_TASKS 16
 
 /**
  * @def STACK_SIZE
- * @brief The size of the stack for each task, in bytes.
+ * @brief The default stack size of a task, in bytes.
+ *
+ * Used when tusk_create_task() is called with a stack size of 0.
+ */
+#define STACK_SIZE 4096 // 4KB stack per task
+
+/**
+ * @def TUSK_MIN_STACK_SIZE
+ * @brief The smallest task stack accepted, in bytes. Smaller requests are rounded up.
+ */
+#define TUSK_MIN_STACK_SIZE 256
+
+/**
+ * @def TUSK_STACK_ARENA_SIZE
+ * @brief The size of the arena that task stacks are carved from, in bytes.
+ *
+ * Stacks of deleted tasks are returned to the arena and merged with their
+ * free neighbours so they can be reused by later tasks.
+ */
+#define TUSK_STACK_ARENA_SIZE (24 * 1024)
+
+/**
+ * @def IDLE_STACK_SIZE
+ * @brief The size of the idle task's stack, in words.
+ */
+#define IDLE_STACK_SIZE 128
+
+/**
+ * @def TUSK_TIME_SLICE_TICKS
+ * @brief The number of system ticks a task may run before another ready task
+ * of the same priority is given the CPU.
+ */
+#define TUSK_TIME_SLICE_TICKS 10
+
+/**
+ * @def TUSK_TICK_RATE_HZ
+ * @brief The frequency of the system tick, in Hz. One tick is the unit of every kernel timeout.
+ */
+#ifndef TUSK_TICK_RATE_HZ
+#define TUSK_TICK_RATE_HZ 1000
+#endif
+
+/**
+ * @def TUSK_CPU_CLOCK_HZ
+ * @brief The processor clock that drives the tick timer, in Hz.
+ *
+ * You MUST adjust this value for your actual system clock frequency.
+ */
+#ifndef TUSK_CPU_CLOCK_HZ
+#define TUSK_CPU_CLOCK_HZ 16000000
+#endif
+
+/**
+ * @def TUSK_KERNEL_INTERRUPT_PRIORITY
+ * @brief The most urgent NVIC priority from which an interrupt may call the kernel.
+ *
+ * Kernel critical sections only mask interrupts of this priority and lower
+ * urgency (numerically equal or greater). More urgent interrupts are never
+ * delayed by the kernel, but must not call any kernel function. The value
+ * is a priority level as it is written to the NVIC before shifting, so it
+ * must be below 1 << __NVIC_PRIO_BITS and must not be 0.
+ */
+#ifndef TUSK_KERNEL_INTERRUPT_PRIORITY
+#define TUSK_KERNEL_INTERRUPT_PRIORITY 5
+#endif
+
+/**
+ * @def TUSK_MAX_PRIORITIES
+ * @brief The number of distinct task priorities.
+ *
+ * The scheduler keeps one bit per priority in a 32-bit ready bitmap, so this
+ * value must not exceed 32. Higher numbers mean higher priority.
+ */
+#define TUSK_MAX_PRIORITIES 32
+
+/**
+ * @def TUSK_IDLE_PRIORITY
+ * @brief The lowest task priority. The idle task always runs at this level.
+ */
+#define TUSK_IDLE_PRIORITY 0
+
+/**
+ * @def TUSK_USE_EDF
+ * @brief Set to 1 to enable earliest-deadline-first (EDF) scheduling of periodic tasks.
+ *
+ * Periodic tasks created with tusk_create_periodic_task() share a single
+ * priority level, TUSK_EDF_PRIORITY, inside which they are ordered by
+ * absolute deadline instead of round-robin. Fixed-priority tasks above that
+ * level still preempt them, so keep those short.
+ */
+#ifndef TUSK_USE_EDF
+#define TUSK_USE_EDF 0
+#endif
+
+/**
+ * @def TUSK_EDF_PRIORITY
+ * @brief The priority level reserved for EDF-scheduled periodic tasks.
+ */
+#define TUSK_EDF_PRIORITY (TUSK_MAX_PRIORITIES - 2)
+
+/**
+ * @def TUSK_EDF_UTILIZATION_SCALE
+ * @brief Fixed-point scale used by the EDF admission test (1.0 == this value).
+ */
+#define TUSK_EDF_UTILIZATION_SCALE 1024
+
+/**
+ * @def TUSK_EDF_UTILIZATION_LIMIT
+ * @brief The maximum total EDF utilization admitted, in units of TUSK_EDF_UTILIZATION_SCALE.
+ *
+ * Defaults to 100% of the CPU, which is the exact EDF bound when every
+ * deadline equals its period.
+ */
+#define TUSK_EDF_UTILIZATION_LIMIT TUSK_EDF_UTILIZATION_SCALE
+
+/**
+ * @def TUSK_USE_STATS
+ * @brief Set to 1 to keep per-task run-time statistics and stack high-water marks.
+ *
+ * Each context switch charges the elapsed port_get_cycles() time to the task
+ * that was running, and every stack is painted with TUSK_STACK_FILL when its
+ * task is created. See tusk_get_task_stats().
+ */
+#ifndef TUSK_USE_STATS
+#define TUSK_USE_STATS 1
+#endif
+
+/**
+ * @def TUSK_STACK_FILL
+ * @brief The pattern task stacks are painted with to measure their high-water mark.
+ */
+#define TUSK_STACK_FILL 0xA5A5A5A5UL
+
+/**
+ * @def TUSK_WAIT_FOREVER
+ * @brief A timeout that makes a blocking call wait until it succeeds.
  */
-#define STACK_SIZE 1024 // 1KB stack per task
+#define TUSK_WAIT_FOREVER 0xFFFFFFFFUL
+
+/**
+ * @def TUSK_NO_WAIT
+ * @brief A timeout that makes a blocking call return at once if it would block.
+ */
+#define TUSK_NO_WAIT 0
 
 /**
  * @name Task States
@@ -41,10 +182,42 @@
 /** @def TASK_BLOCKED
  *  @brief A task state indicating that the task is blocked, waiting for an event (e.g., a delay to expire). */
 #define TASK_BLOCKED 2
+
+/** @def TASK_INACTIVE
+ *  @brief A task state indicating that the TCB is unused and available for a new task. */
+#define TASK_INACTIVE 3
+
+/** @def TASK_DELETED
+ *  @brief A task state indicating that the task deleted itself and its stack is awaiting reclamation. */
+#define TASK_DELETED 4
 /** @} */
 
 // Forward declaration for the tcb struct.
 struct tcb;
+struct tusk_mutex;
+
+/**
+ * @struct wait_queue_t
+ * @brief The tasks blocked on a kernel object, such as a mutex or semaphore.
+ *
+ * A doubly linked list through the TCBs' wait_next and wait_prev fields,
+ * sorted by priority with equal priorities in FIFO order. Because the tail
+ * is kept as well, queueing a waiter that is no more urgent than the last
+ * one takes constant time, and so does removing any waiter.
+ */
+typedef struct wait_queue {
+	/**
+     * @var head
+     * @brief The most urgent waiter, or NULL if the queue is empty.
+     */
+	struct tcb *head;
+
+	/**
+     * @var tail
+     * @brief The least urgent waiter, or NULL if the queue is empty.
+     */
+	struct tcb *tail;
+} wait_queue_t;
 
 /**
  * @struct tcb
@@ -61,12 +234,43 @@ typedef struct tcb {
      */
 	uint32_t *stack_pointer;
 
+	/**
+     * @var stack_base
+     * @brief Pointer to the lowest address of the task's stack.
+     */
+	uint32_t *stack_base;
+
+	/**
+     * @var stack_size
+     * @brief The size of the task's stack, in bytes.
+     */
+	uint32_t stack_size;
+
+	/**
+     * @var owns_stack
+     * @brief Non-zero if the stack was carved from the stack arena and must be returned to it.
+     */
+	uint8_t owns_stack;
+
 	/**
      * @var state
      * @brief The current state of the task (e.g., TASK_RUNNING, TASK_READY, TASK_BLOCKED).
      */
 	uint8_t state;
 
+	/**
+     * @var priority
+     * @brief The scheduling priority of the task (0 = lowest, TUSK_MAX_PRIORITIES - 1 = highest).
+     * While the task holds mutexes this may be raised above base_priority.
+     */
+	uint8_t priority;
+
+	/**
+     * @var base_priority
+     * @brief The priority the task was created with, before any inheritance or ceiling boost.
+     */
+	uint8_t base_priority;
+
 	/**
      * @var wakeup_time
      * @brief The system tick count at which a blocked task should be woken up.
@@ -76,18 +280,214 @@ typedef struct tcb {
 
 	/**
      * @var next_tcb
-     * @brief Pointer to the next TCB in the scheduler's list of tasks.
-     * This is used to form a circular linked list for round-robin scheduling.
+     * @brief Pointer to the next TCB in the ready queue of the task's priority.
+     * Each ready queue is a circular doubly linked list used for round-robin
+     * scheduling among tasks of equal priority.
      */
 	struct tcb *next_tcb;
 
+	/**
+     * @var prev_tcb
+     * @brief Pointer to the previous TCB in the ready queue of the task's priority.
+     */
+	struct tcb *prev_tcb;
+
+	/**
+     * @var delay_next
+     * @brief Pointer to the next TCB in the delay list, which is kept sorted by wakeup_time.
+     */
+	struct tcb *delay_next;
+
+	/**
+     * @var delay_prev
+     * @brief Pointer to the previous TCB in the delay list.
+     */
+	struct tcb *delay_prev;
+
+#if TUSK_USE_EDF
+	/**
+     * @var period
+     * @brief The release period of an EDF task in ticks, or 0 for a fixed-priority task.
+     */
+	uint32_t period;
+
+	/**
+     * @var relative_deadline
+     * @brief The deadline of each job, in ticks after its release.
+     */
+	uint32_t relative_deadline;
+
+	/**
+     * @var wcet
+     * @brief The worst-case execution time budget of each job, in ticks.
+     */
+	uint32_t wcet;
+
+	/**
+     * @var release_time
+     * @brief The system tick count at which the current job was released.
+     */
+	uint32_t release_time;
+
+	/**
+     * @var absolute_deadline
+     * @brief The system tick count by which the current job must complete.
+     */
+	uint32_t absolute_deadline;
+
+	/**
+     * @var deadline_misses
+     * @brief The number of jobs that completed after their absolute deadline.
+     */
+	uint32_t deadline_misses;
+#endif
+
 	/**
      * @var wait_next
      * @brief Pointer to the next TCB in a waiting list for a resource like a mutex or semaphore.
      */
 	struct tcb *wait_next;
+
+	/**
+     * @var wait_prev
+     * @brief Pointer to the previous TCB in the waiting list.
+     */
+	struct tcb *wait_prev;
+
+	/**
+     * @var wait_list
+     * @brief Pointer to the wait queue the task is queued on, or NULL.
+     */
+	wait_queue_t *wait_list;
+
+	/**
+     * @var timed_out
+     * @brief Set when a blocked task was woken by its timeout rather than by the event it waited for.
+     */
+	uint8_t timed_out;
+
+	/**
+     * @var held_mutexes
+     * @brief The mutexes the task owns, linked through their next_held field.
+     */
+	struct tusk_mutex *held_mutexes;
+
+	/**
+     * @var pending_mutex
+     * @brief A mutex the task is taking or releasing without a critical section.
+     *
+     * It may be locked to the task without being on held_mutexes, so
+     * tusk_delete_task() checks it as well.
+     */
+	struct tusk_mutex *pending_mutex;
+
+	/**
+     * @var blocked_on
+     * @brief The mutex the task is waiting for, or NULL. Used to follow chains of owners.
+     */
+	struct tusk_mutex *blocked_on;
+
+	/**
+     * @var wait_message
+     * @brief The message a task blocked on a queue is sending, or has been handed.
+     */
+	void *wait_message;
+
+	/**
+     * @var event_bits
+     * @brief The bits an event group waiter waits for, replaced by the group's flags when it is woken.
+     */
+	uint32_t event_bits;
+
+	/**
+     * @var event_options
+     * @brief How an event group waiter matches its bits (wait for all, clear on exit).
+     */
+	uint8_t event_options;
+
+	/**
+     * @var notify_value
+     * @brief The task's notification word, updated by tusk_notify().
+     */
+	uint32_t notify_value;
+
+	/**
+     * @var notify_state
+     * @brief Whether a notification is pending or the task is waiting for one.
+     */
+	uint8_t notify_state;
+
+	/**
+     * @var pool_caches
+     * @brief The memory pool caches the task has set up, flushed when it is deleted.
+     */
+	struct mem_pool_cache *pool_caches;
+
+#if TUSK_USE_STATS
+	/**
+     * @var run_time
+     * @brief The total time the task has run, in port_get_cycles() units.
+     */
+	uint64_t run_time;
+
+	/**
+     * @var switch_count
+     * @brief The number of times the task has been switched in.
+     */
+	uint32_t switch_count;
+#endif
 } tcb_t;
 
+#if TUSK_USE_STATS
+/**
+ * @struct tusk_task_stats_t
+ * @brief A snapshot of one task's statistics, filled in by tusk_get_task_stats().
+ */
+typedef struct {
+	/**
+     * @var task
+     * @brief The task handle. The idle and timer service tasks are included.
+     */
+	tcb_t *task;
+
+	/**
+     * @var priority
+     * @brief The task priority.
+     */
+	uint8_t priority;
+
+	/**
+     * @var state
+     * @brief The task state (TASK_READY, TASK_BLOCKED, ...).
+     */
+	uint8_t state;
+
+	/**
+     * @var run_time
+     * @brief The total time the task has run, in port_get_cycles() units.
+     */
+	uint64_t run_time;
+
+	/**
+     * @var switch_count
+     * @brief The number of times the task has been switched in.
+     */
+	uint32_t switch_count;
+
+	/**
+     * @var stack_size
+     * @brief The size of the task's stack, in bytes.
+     */
+	uint32_t stack_size;
+
+	/**
+     * @var stack_high_water
+     * @brief The most stack the task has ever used, in bytes.
+     */
+	uint32_t stack_high_water;
+} tusk_task_stats_t;
+#endif
+
 /* Public Functions */
 
 /**
@@ -101,12 +501,124 @@ void tusk_init(void);
 /**
  * @brief Creates a new task and adds it to the scheduler.
  *
+ * The scheduler always runs the highest-priority ready task. Tasks that share
+ * a priority are scheduled round-robin. The task's stack is carved from the
+ * stack arena and returned to it when the task is deleted.
+ *
  * @param task_handler A pointer to the function that implements the task's behavior.
- *                     This function should have a `void (*)(void)` signature and should
- *                     not return.
- * @return int 0 on success, or a negative value on failure (e.g., if MAX_TASKS is exceeded).
+ *                     This function should have a `void (*)(void)` signature. If it
+ *                     returns, the task deletes itself.
+ * @param priority The priority of the task, from TUSK_IDLE_PRIORITY up to
+ *                 TUSK_MAX_PRIORITIES - 1.
+ * @param stack_size The stack size in bytes, or 0 for STACK_SIZE.
+ * @return A handle to the new task, or NULL on failure (e.g., if MAX_TASKS is exceeded,
+ *         the priority is out of range, the stack arena is exhausted or
+ *         stack_size exceeds TUSK_STACK_ARENA_SIZE).
+ */
+tcb_t *tusk_create_task(void (*task_handler)(void), uint8_t priority,
+			size_t stack_size);
+
+/**
+ * @brief Creates a new task that runs on a caller-supplied stack.
+ *
+ * Identical to tusk_create_task(), except that the stack is not taken from
+ * the arena. The buffer must stay valid for the lifetime of the task and is
+ * not freed when the task is deleted.
+ *
+ * @param task_handler A pointer to the function that implements the task's behavior.
+ * @param priority The priority of the task.
+ * @param stack A pointer to the lowest word of the stack buffer. Should be 8-byte aligned.
+ * @param stack_size The size of the stack buffer in bytes, at least TUSK_MIN_STACK_SIZE.
+ *                   Rounded down to a multiple of 8.
+ * @return A handle to the new task, or NULL on failure.
+ */
+tcb_t *tusk_create_task_static(void (*task_handler)(void), uint8_t priority,
+			       uint32_t *stack, size_t stack_size);
+
+/**
+ * @brief Deletes a task and returns its TCB and stack for reuse.
+ *
+ * The task is removed from whichever ready, delay or waiting list it is on.
+ * Every mutex the task still holds is released, whatever its recursion
+ * depth, and handed to its most urgent waiter; the data it protects may be
+ * left half-updated. When a task deletes itself its stack is reclaimed
+ * later by the idle task, and this function does not return.
+ *
+ * The task's memory pool caches (mem_pool_cache_t) are flushed back to
+ * their pools. If another task is deleted while in the middle of a cache
+ * operation, that one cache is only detached, since its contents may be
+ * half-updated; its blocks stay in it until it is flushed explicitly.
+ *
+ * @param task The task to delete, or NULL to delete the calling task.
+ * @return int 0 on success, or a negative value if the handle is not a live task.
+ */
+int tusk_delete_task(tcb_t *task);
+
+/**
+ * @brief Returns the handle of the calling task.
+ *
+ * @return The TCB of the running task.
+ */
+tcb_t *tusk_current_task(void);
+
+#if TUSK_USE_STATS
+/**
+ * @brief Takes a snapshot of the run-time statistics of every task.
+ *
+ * Compare each task's `run_time` to `total_run_time` to get its share of the
+ * CPU; the entry of the idle task gives the idle share. Stack high-water marks
+ * are measured by scanning for the paint pattern, which takes time
+ * proportional to the stack sizes, so avoid calling this from time-critical
+ * code. The scan runs with interrupts enabled.
+ *
+ * @param stats An array to receive one entry per task.
+ * @param max_entries The number of entries `stats` can hold.
+ * @param total_run_time If not NULL, receives the time elapsed since
+ *                       tusk_start(), in port_get_cycles() units.
+ * @return The number of entries written.
+ */
+uint32_t tusk_get_task_stats(tusk_task_stats_t *stats, uint32_t max_entries,
+			     uint64_t *total_run_time);
+#endif
+
+#if TUSK_USE_EDF
+/**
+ * @brief Creates a periodic task scheduled by earliest deadline first.
+ *
+ * The task's first job is released immediately. Every job must end by calling
+ * tusk_wait_next_period(). The task is only admitted if the total density of
+ * all EDF tasks, the sum of wcet / deadline, stays within
+ * TUSK_EDF_UTILIZATION_LIMIT.
+ *
+ * @param task_handler A pointer to the function that implements the task's behavior.
+ * @param period The release period in ticks.
+ * @param deadline The relative deadline of each job in ticks, at most `period`.
+ * @param wcet The worst-case execution time of each job in ticks, at most `deadline`.
+ * @param stack_size The stack size in bytes, or 0 for STACK_SIZE.
+ * @return A handle to the new task, or NULL if the parameters are invalid, no
+ *         TCB or stack is available or the admission test fails.
+ */
+tcb_t *tusk_create_periodic_task(void (*task_handler)(void), uint32_t period,
+				 uint32_t deadline, uint32_t wcet,
+				 size_t stack_size);
+
+/**
+ * @brief Ends the current job of an EDF task and sleeps until the next release.
+ *
+ * If the job finished after its absolute deadline, the task's deadline-miss
+ * counter is incremented. If the next release is already due, the next job
+ * starts immediately.
+ */
+void tusk_wait_next_period(void);
+
+/**
+ * @brief Returns the number of deadlines an EDF task has missed.
+ *
+ * @param task The task to query, or NULL for the calling task.
+ * @return The deadline-miss counter of the task.
  */
-int tusk_create_task(void (*task_handler)(void));
+uint32_t tusk_get_deadline_misses(tcb_t *task);
+#endif
 
 /**
  * @brief Starts the Tusk RTOS scheduler and begins multitasking.
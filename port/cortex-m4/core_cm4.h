@@ -0,0 +1,156 @@
+#ifndef __CORE_CM4_H_GENERIC
+#define __CORE_CM4_H_GENERIC
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of priority bits the NVIC implements (4 on the STM32F4) */
+#ifndef __NVIC_PRIO_BITS
+#define __NVIC_PRIO_BITS 4U
+#endif
+
+/* IO definitions */
+#ifdef __cplusplus
+#define __I volatile /*!< Defines 'read only' permissions */
+#else
+#define __I volatile const /*!< Defines 'read only' permissions */
+#endif
+#define __O volatile /*!< Defines 'write only' permissions */
+#define __IO volatile /*!< Defines 'read / write' permissions */
+
+/* Memory mapping of Core Hardware */
+#define SCS_BASE (0xE000E000UL) /*!< System Control Space Base Address */
+#define SysTick_BASE (SCS_BASE + 0x0010UL) /*!< SysTick Base Address */
+#define SCB_BASE (SCS_BASE + 0x0D00UL) /*!< System Control Block Base Address */
+
+typedef struct {
+	__IO uint32_t
+		CTRL; /*!< Offset: 0x000 (R/W)  SysTick Control and Status Register */
+	__IO uint32_t
+		LOAD; /*!< Offset: 0x004 (R/W)  SysTick Reload Value Register */
+	__IO uint32_t
+		VAL; /*!< Offset: 0x008 (R/W)  SysTick Current Value Register */
+	__I uint32_t
+		CALIB; /*!< Offset: 0x00C (R/ )  SysTick Calibration Register */
+} SysTick_Type;
+
+typedef struct {
+	__I uint32_t CPUID; /*!< Offset: 0x000 (R/ )  CPUID Base Register */
+	__IO uint32_t
+		ICSR; /*!< Offset: 0x004 (R/W)  Interrupt Control and State Register */
+	__IO uint32_t
+		VTOR; /*!< Offset: 0x008 (R/W)  Vector Table Offset Register */
+	// ... other registers ...
+} SCB_Type;
+
+#define SysTick \
+	((SysTick_Type *)SysTick_BASE) /*!< SysTick configuration struct */
+#define SCB ((SCB_Type *)SCB_BASE) /*!< SCB configuration struct */
+
+/* SCB Interrupt Control State Register Definitions */
+#define SCB_ICSR_PENDSVSET_Pos 28U /*!< SCB ICSR: PENDSVSET Position */
+#define SCB_ICSR_PENDSVSET_Msk \
+	(1UL << SCB_ICSR_PENDSVSET_Pos) /*!< SCB ICSR: PENDSVSET Mask */
+#define SCB_ICSR_PENDSTSET_Pos 26U /*!< SCB ICSR: PENDSTSET Position */
+#define SCB_ICSR_PENDSTSET_Msk \
+	(1UL << SCB_ICSR_PENDSTSET_Pos) /*!< SCB ICSR: PENDSTSET Mask */
+
+/* Intrinsic Functions */
+__attribute__((always_inline)) static inline void __enable_irq(void)
+{
+	__asm volatile("cpsie i" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline void __disable_irq(void)
+{
+	__asm volatile("cpsid i" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline uint32_t __get_PRIMASK(void)
+{
+	uint32_t result;
+
+	__asm volatile("mrs %0, primask" : "=r"(result));
+	return result;
+}
+
+__attribute__((always_inline)) static inline void __set_PRIMASK(uint32_t priMask)
+{
+	__asm volatile("msr primask, %0" : : "r"(priMask) : "memory");
+}
+
+__attribute__((always_inline)) static inline uint32_t __get_BASEPRI(void)
+{
+	uint32_t result;
+
+	__asm volatile("mrs %0, basepri" : "=r"(result));
+	return result;
+}
+
+__attribute__((always_inline)) static inline void __set_BASEPRI(uint32_t basePri)
+{
+	__asm volatile("msr basepri, %0" : : "r"(basePri) : "memory");
+}
+
+__attribute__((always_inline)) static inline void __DSB(void)
+{
+	__asm volatile("dsb 0xF" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline void __DMB(void)
+{
+	__asm volatile("dmb 0xF" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline void __ISB(void)
+{
+	__asm volatile("isb 0xF" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline uint8_t __CLZ(uint32_t value)
+{
+	if (value == 0U) {
+		return 32U;
+	}
+	return (uint8_t)__builtin_clz(value);
+}
+
+__attribute__((always_inline)) static inline uint32_t
+__LDREXW(volatile uint32_t *addr)
+{
+	uint32_t result;
+
+	__asm volatile("ldrex %0, %1" : "=r"(result) : "Q"(*addr) : "memory");
+	return result;
+}
+
+__attribute__((always_inline)) static inline uint32_t
+__STREXW(uint32_t value, volatile uint32_t *addr)
+{
+	uint32_t result;
+
+	__asm volatile("strex %0, %2, %1"
+		       : "=&r"(result), "=Q"(*addr)
+		       : "r"(value)
+		       : "memory");
+	return result;
+}
+
+__attribute__((always_inline)) static inline void __CLREX(void)
+{
+	__asm volatile("clrex" : : : "memory");
+}
+
+__attribute__((always_inline)) static inline void __WFI(void)
+{
+	__asm volatile("wfi");
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CORE_CM4_H_GENERIC */
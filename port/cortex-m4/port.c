@@ -0,0 +1,102 @@
+#include "../../include/port.h"
+#include "../../include/kernel.h"
+#include <stddef.h> // For NULL
+
+/* Called from port_start_first_task (port_asm.S) right before the first task runs. */
+void port_setup_tick(void);
+
+volatile uint32_t port_critical_nesting = 0;
+
+// PendSV_Handler (port_asm.S) raises BASEPRI to this while it switches tasks
+const uint32_t port_kernel_basepri = PORT_KERNEL_BASEPRI;
+
+#if TUSK_KERNEL_INTERRUPT_PRIORITY == 0 || \
+	TUSK_KERNEL_INTERRUPT_PRIORITY >= (1 << __NVIC_PRIO_BITS)
+#error "TUSK_KERNEL_INTERRUPT_PRIORITY must be between 1 and (1 << __NVIC_PRIO_BITS) - 1"
+#endif
+
+/* Builds the initial exception frame so the first switch "returns" into the task. */
+uint32_t *port_init_stack(uint32_t *stack_top, void (*task_handler)(void),
+			  void (*task_exit)(void))
+{
+	// The exception frame must be 8-byte aligned
+	stack_top = (uint32_t *)((uint32_t)stack_top & ~7UL);
+
+	// Initialize the task stack for Cortex-M
+	*(--stack_top) = 0x01000000; // xPSR (Thumb state)
+	*(--stack_top) = (uint32_t)task_handler & ~1UL; // PC (program counter)
+	*(--stack_top) = (uint32_t)task_exit; // LR (link register)
+	*(--stack_top) = 0; // R12
+	*(--stack_top) = 0; // R3
+	*(--stack_top) = 0; // R2
+	*(--stack_top) = 0; // R1
+	*(--stack_top) = 0; // R0
+#if defined(__ARM_FP)
+	// EXC_RETURN: Thread mode, PSP, no FP context yet. The first FPU
+	// instruction the task executes makes later switches save S16-S31.
+	*(--stack_top) = 0xFFFFFFFD;
+#endif
+	// The processor automatically saves R4-R11
+	*(--stack_top) = 0; // R11
+	*(--stack_top) = 0; // R10
+	*(--stack_top) = 0; // R9
+	*(--stack_top) = 0; // R8
+	*(--stack_top) = 0; // R7
+	*(--stack_top) = 0; // R6
+	*(--stack_top) = 0; // R5
+	*(--stack_top) = 0; // R4
+
+	return stack_top;
+}
+
+void port_release_task(tcb_t *task)
+{
+	// The whole context lives on the task's own stack
+	(void)task;
+}
+
+void port_setup_tick(void)
+{
+	// SysTick runs from the processor clock. Adjust TUSK_CPU_CLOCK_HZ to
+	// your actual system clock, e.g. 16MHz / 1000Hz = 16,000 per tick.
+	SysTick->LOAD = (TUSK_CPU_CLOCK_HZ / TUSK_TICK_RATE_HZ) - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL = 0x07; // Enable, Use Processor Clock, Enable Interrupt
+}
+
+uint32_t port_get_cycles(void)
+{
+	uint32_t ticks, value, wrapped;
+
+	do {
+		ticks = rtos_ticks;
+		value = SysTick->VAL;
+		// The counter wrapped but the tick has not been handled yet,
+		// e.g. because interrupts are masked: count it ourselves.
+		wrapped = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) ? 1 : 0;
+		if (wrapped) {
+			value = SysTick->VAL;
+		}
+	} while (ticks != rtos_ticks); // A tick was handled meanwhile, retry
+
+	return (ticks + wrapped) * (SysTick->LOAD + 1) +
+	       (SysTick->LOAD - value);
+}
+
+void port_exit(int status)
+{
+	// Semihosting SYS_EXIT_EXTENDED with ADP_Stopped_ApplicationExit
+	volatile uint32_t block[2] = { 0x20026, (uint32_t)status };
+
+	__asm volatile("mov r0, #0x20\n"
+		       "mov r1, %0\n"
+		       "bkpt 0xAB\n"
+		       :
+		       : "r"(block)
+		       : "r0", "r1", "memory");
+
+	// Without a debugger attached there is nothing to return to
+	port_disable_interrupts();
+	while (1) {
+	}
+}
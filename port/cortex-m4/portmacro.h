@@ -0,0 +1,143 @@
+/**
+ * @file portmacro.h
+ * @brief Inline port primitives for the ARM Cortex-M4.
+ * @author Dimitrios Papakonstantinou
+ *
+ * See port.h for the contract every port has to fulfil.
+ */
+
+#ifndef PORTMACRO_H_
+#define PORTMACRO_H_
+
+#include <stdint.h>
+#include "core_cm4.h"
+
+// SysTick is clocked from the processor clock
+#define PORT_CYCLES_HZ TUSK_CPU_CLOCK_HZ
+
+// BASEPRI value that masks every interrupt allowed to call the kernel
+#define PORT_KERNEL_BASEPRI \
+	((TUSK_KERNEL_INTERRUPT_PRIORITY << (8U - __NVIC_PRIO_BITS)) & 0xFFU)
+
+// Depth of nested port_disable_interrupts() calls (defined in port.c)
+extern volatile uint32_t port_critical_nesting;
+
+/**
+ * @brief Masks every interrupt at or below TUSK_KERNEL_INTERRUPT_PRIORITY.
+ *
+ * Calls nest: interrupts are only unmasked by the outermost
+ * port_enable_interrupts(). More urgent interrupts keep running.
+ */
+static inline void port_disable_interrupts(void)
+{
+	__set_BASEPRI(PORT_KERNEL_BASEPRI);
+	// Make sure the new mask is in effect before the critical section
+	__DSB();
+	__ISB();
+	port_critical_nesting++;
+}
+
+static inline void port_enable_interrupts(void)
+{
+	if (--port_critical_nesting == 0) {
+		__set_BASEPRI(0);
+	}
+}
+
+/**
+ * @brief Masks kernel interrupts from a handler and returns the previous mask.
+ *
+ * Only the *_from_isr kernel functions may be called until the mask is
+ * restored.
+ */
+static inline uint32_t port_set_interrupt_mask_from_isr(void)
+{
+	uint32_t mask = __get_BASEPRI();
+
+	__set_BASEPRI(PORT_KERNEL_BASEPRI);
+	__DSB();
+	__ISB();
+	return mask;
+}
+
+static inline void port_clear_interrupt_mask_from_isr(uint32_t mask)
+{
+	__set_BASEPRI(mask);
+}
+
+/**
+ * @brief Pends PendSV so the scheduler runs as soon as interrupts allow it.
+ */
+static inline void port_trigger_context_switch(void)
+{
+	// SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
+	// Using a direct address for compatibility
+	*(volatile uint32_t *)0xE000ED04 |= (1 << 28);
+}
+
+static inline uint8_t port_clz(uint32_t value)
+{
+	return __CLZ(value);
+}
+
+/**
+ * @brief Atomically adds `delta` to `*value` and returns the previous value.
+ *
+ * The exclusive monitor is cleared on every exception entry, so an interrupt
+ * between LDREX and STREX simply makes us retry. Like port_atomic_cas(), this
+ * is a full barrier.
+ */
+static inline uint32_t port_atomic_add(volatile uint32_t *value, uint32_t delta)
+{
+	uint32_t old;
+
+	__DMB();
+	do {
+		old = __LDREXW(value);
+	} while (__STREXW(old + delta, value) != 0);
+	__DMB();
+	return old;
+}
+
+/**
+ * @brief Atomically replaces `*value` with `desired` if it equals `expected`.
+ *
+ * A full barrier, so it works both to take a lock (acquire) and to hand over
+ * the data written before it (release, e.g. unlocking a mutex or pushing a
+ * pool block): no access moves across it, neither in the compiler nor on
+ * the bus.
+ *
+ * @return 1 if the value was replaced, 0 if it did not match.
+ */
+static inline uint8_t port_atomic_cas(volatile uint32_t *value,
+				      uint32_t expected, uint32_t desired)
+{
+	__DMB();
+	do {
+		if (__LDREXW(value) != expected) {
+			__CLREX();
+			return 0;
+		}
+	} while (__STREXW(desired, value) != 0);
+	__DMB();
+	return 1;
+}
+
+static inline uint8_t port_atomic_cas_ptr(volatile uintptr_t *value,
+					  uintptr_t expected, uintptr_t desired)
+{
+	return port_atomic_cas((volatile uint32_t *)value, expected, desired);
+}
+
+static inline void port_memory_barrier(void)
+{
+	__DMB();
+}
+
+static inline void port_idle(void)
+{
+	// Sleep until the next interrupt instead of spinning
+	__WFI();
+}
+
+#endif // PORTMACRO_H_
@@ -0,0 +1,244 @@
+/*
+ * Linux host port of Tusk RTOS.
+ *
+ * Each task runs on a ucontext with its own host stack. The tick is a
+ * SIGALRM interval timer whose handler plays the part of SysTick, and a
+ * context switch requested from it is carried out right inside the handler,
+ * the same way PendSV tail-chains after SysTick on the target. The signal
+ * mask is saved and restored with every context, so a task that was
+ * preempted in the handler finishes it when it is switched back in.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include "../../include/port.h"
+#include "../../include/kernel.h"
+
+// Tasks run on host stacks of their own. Signal frames and libc calls need
+// far more room than the stacks sized for the target.
+#define HOST_STACK_SIZE (256 * 1024)
+
+typedef struct {
+	ucontext_t context;
+	void (*task_handler)(void);
+	void (*task_exit)(void);
+	uint8_t stack[HOST_STACK_SIZE];
+} host_task_t;
+
+// Keeps the compiler from moving memory accesses across flag updates that a
+// signal handler may observe.
+#define barrier() __asm__ volatile("" : : : "memory")
+
+// --- Simulated Interrupt State ---
+static volatile sig_atomic_t interrupts_enabled = 1;
+static volatile uint32_t critical_nesting = 0;
+static volatile sig_atomic_t in_interrupt = 0;
+static volatile sig_atomic_t tick_pending = 0;
+static volatile sig_atomic_t switch_pending = 0;
+static volatile sig_atomic_t scheduler_running = 0;
+static void (*volatile isr_hook)(void) = NULL;
+
+static inline host_task_t *task_context(tcb_t *task)
+{
+	return (host_task_t *)task->stack_pointer;
+}
+
+/* The simulated PendSV. Interrupts must be disabled. */
+static void context_switch(void)
+{
+	tcb_t *prev = current_tcb;
+
+	switch_pending = 0;
+	rtos_scheduler();
+	if (current_tcb != prev) {
+		// Returns once `prev` is switched back in
+		swapcontext(&task_context(prev)->context,
+			    &task_context(current_tcb)->context);
+	}
+}
+
+/* Runs deferred ticks and context switches, like the NVIC does once BASEPRI is cleared. */
+static void run_pending(void)
+{
+	while (tick_pending || switch_pending) {
+		interrupts_enabled = 0;
+		barrier();
+		if (tick_pending) {
+			tick_pending = 0;
+			in_interrupt = 1;
+			SysTick_Handler();
+			if (isr_hook != NULL) {
+				isr_hook();
+			}
+			in_interrupt = 0;
+		}
+		if (switch_pending) {
+			context_switch();
+		}
+		barrier();
+		interrupts_enabled = 1;
+		barrier();
+	}
+}
+
+static void tick_handler(int signal)
+{
+	(void)signal;
+
+	tick_pending = 1;
+	if (interrupts_enabled && !in_interrupt) {
+		run_pending();
+	}
+}
+
+/* Unmasks interrupts and runs whatever they deferred. */
+static void unmask_interrupts(void)
+{
+	barrier();
+	interrupts_enabled = 1;
+	barrier();
+	if (scheduler_running && (tick_pending || switch_pending)) {
+		run_pending();
+	}
+}
+
+/* First code a new task runs; interrupts are still disabled by the switch that got us here. */
+static void task_entry(void)
+{
+	host_task_t *task = task_context(current_tcb);
+
+	// The switch masked interrupts without entering a critical section
+	unmask_interrupts();
+	task->task_handler();
+	task->task_exit();
+}
+
+void port_disable_interrupts(void)
+{
+	// The tick handler runs with the tick masked already
+	if (in_interrupt) {
+		return;
+	}
+	interrupts_enabled = 0;
+	barrier();
+	critical_nesting++;
+}
+
+void port_enable_interrupts(void)
+{
+	if (in_interrupt) {
+		return;
+	}
+	if (--critical_nesting == 0) {
+		unmask_interrupts();
+	}
+}
+
+uint32_t port_set_interrupt_mask_from_isr(void)
+{
+	uint32_t mask = interrupts_enabled;
+
+	interrupts_enabled = 0;
+	barrier();
+	return mask;
+}
+
+void port_clear_interrupt_mask_from_isr(uint32_t mask)
+{
+	if (mask && !in_interrupt) {
+		unmask_interrupts();
+	}
+}
+
+void port_host_set_isr_hook(void (*hook)(void))
+{
+	isr_hook = hook;
+}
+
+void port_trigger_context_switch(void)
+{
+	switch_pending = 1;
+	if (scheduler_running && interrupts_enabled && !in_interrupt) {
+		run_pending();
+	}
+}
+
+void port_idle(void)
+{
+	// Sleep until the next tick instead of spinning
+	pause();
+}
+
+uint32_t *port_init_stack(uint32_t *stack_top, void (*task_handler)(void),
+			  void (*task_exit)(void))
+{
+	host_task_t *task = malloc(sizeof(host_task_t));
+
+	// The target stack is only kept for bookkeeping
+	(void)stack_top;
+
+	if (task == NULL || getcontext(&task->context) != 0) {
+		fprintf(stderr, "tusk: cannot allocate a host task context\n");
+		abort();
+	}
+	task->task_handler = task_handler;
+	task->task_exit = task_exit;
+	task->context.uc_stack.ss_sp = task->stack;
+	task->context.uc_stack.ss_size = sizeof(task->stack);
+	task->context.uc_link = NULL;
+	sigemptyset(&task->context.uc_sigmask);
+	makecontext(&task->context, task_entry, 0);
+
+	return (uint32_t *)task;
+}
+
+void port_release_task(tcb_t *task)
+{
+	free(task_context(task));
+}
+
+void port_start_first_task(void)
+{
+	struct sigaction action;
+	struct itimerval tick;
+
+	interrupts_enabled = 0;
+	critical_nesting = 0;
+	tick_pending = 0;
+	switch_pending = 0;
+	scheduler_running = 1;
+
+	action.sa_handler = tick_handler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &action, NULL);
+
+	tick.it_interval.tv_sec = 0;
+	tick.it_interval.tv_usec = 1000000 / TUSK_TICK_RATE_HZ;
+	tick.it_value = tick.it_interval;
+	setitimer(ITIMER_REAL, &tick, NULL);
+
+	setcontext(&task_context(current_tcb)->context);
+
+	// setcontext() only returns on failure
+	abort();
+}
+
+uint32_t port_get_cycles(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL +
+			  (uint64_t)now.tv_nsec);
+}
+
+void port_exit(int status)
+{
+	exit(status);
+}
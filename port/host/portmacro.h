@@ -0,0 +1,108 @@
+/**
+ * @file portmacro.h
+ * @brief Port primitives for the Linux host simulation.
+ * @author Dimitrios Papakonstantinou
+ *
+ * Interrupts are simulated: the tick is a SIGALRM interval timer, and
+ * "disabling interrupts" sets a flag that makes the signal handler defer the
+ * tick instead of blocking the signal, so critical sections cost no system
+ * calls. Critical sections nest like on the target. Deferred ticks and
+ * context switches are run when interrupts are enabled again, just like the
+ * NVIC does when BASEPRI is cleared.
+ *
+ * See port.h for the contract every port has to fulfil.
+ */
+
+#ifndef PORTMACRO_H_
+#define PORTMACRO_H_
+
+#include <stdint.h>
+
+// port_get_cycles() returns nanoseconds of CLOCK_MONOTONIC
+#define PORT_CYCLES_HZ 1000000000UL
+
+void port_disable_interrupts(void);
+void port_enable_interrupts(void);
+uint32_t port_set_interrupt_mask_from_isr(void);
+void port_clear_interrupt_mask_from_isr(uint32_t mask);
+void port_trigger_context_switch(void);
+void port_idle(void);
+
+/**
+ * @brief Installs a function the simulated tick interrupt calls after SysTick_Handler().
+ *
+ * Stands in for a peripheral interrupt at the kernel priority: it preempts
+ * tasks at any instruction unless interrupts are disabled, so it may only
+ * use the *_from_isr and lock-free kernel functions. Pass NULL to remove it.
+ * Host only, for tests.
+ */
+void port_host_set_isr_hook(void (*hook)(void));
+
+static inline uint8_t port_clz(uint32_t value)
+{
+	if (value == 0U) {
+		return 32U;
+	}
+	return (uint8_t)__builtin_clz(value);
+}
+
+static inline uint32_t port_atomic_add(volatile uint32_t *value, uint32_t delta)
+{
+	return __atomic_fetch_add(value, delta, __ATOMIC_ACQ_REL);
+}
+
+static inline void port_memory_barrier(void)
+{
+	// Interrupts are signals on the same thread, which see every store in
+	// program order once the compiler has emitted it
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+/*
+ * The simulation runs on a single host thread, so compare-and-swap only has
+ * to be atomic with respect to the tick signal, which can only arrive
+ * between instructions. On x86 a single cmpxchg without the lock prefix
+ * does that at a fraction of the cost of a bus-locked one, just like
+ * LDREX/STREX on the target.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint8_t port_atomic_cas(volatile uint32_t *value,
+				      uint32_t expected, uint32_t desired)
+{
+	uint8_t swapped;
+
+	__asm__ volatile("cmpxchgl %3, %1\n\tsete %0"
+			 : "=q"(swapped), "+m"(*value), "+a"(expected)
+			 : "r"(desired)
+			 : "memory", "cc");
+	return swapped;
+}
+
+static inline uint8_t port_atomic_cas_ptr(volatile uintptr_t *value,
+					  uintptr_t expected, uintptr_t desired)
+{
+	uint8_t swapped;
+
+	__asm__ volatile("cmpxchg %3, %1\n\tsete %0"
+			 : "=q"(swapped), "+m"(*value), "+a"(expected)
+			 : "r"(desired)
+			 : "memory", "cc");
+	return swapped;
+}
+#else
+static inline uint8_t port_atomic_cas(volatile uint32_t *value,
+				      uint32_t expected, uint32_t desired)
+{
+	return __atomic_compare_exchange_n(value, &expected, desired, 0,
+					   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static inline uint8_t port_atomic_cas_ptr(volatile uintptr_t *value,
+					  uintptr_t expected, uintptr_t desired)
+{
+	return __atomic_compare_exchange_n(value, &expected, desired, 0,
+					   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#endif
+
+#endif // PORTMACRO_H_
@@ -0,0 +1,38 @@
+/*
+ * Serial output for the Linux host port. Everything goes to stdout.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "../../include/serial.h"
+
+void uart_init(void)
+{
+}
+
+void serial_print(const char *str)
+{
+	size_t len = strlen(str);
+
+	while (len > 0) {
+		ssize_t written = write(STDOUT_FILENO, str, len);
+		if (written <= 0) {
+			return;
+		}
+		str += written;
+		len -= (size_t)written;
+	}
+}
+
+void serial_print_dec(uint32_t value)
+{
+	char buffer[11];
+	char *digit = &buffer[sizeof(buffer) - 1];
+
+	*digit = '\0';
+	do {
+		*(--digit) = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	serial_print(digit);
+}
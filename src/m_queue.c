@@ -1,42 +1,296 @@
 #include "../include/m_queue.h"
+#include "../include/kernel.h"
 
 void queue_init(message_queue_t *q)
 {
 	q->head = 0;
 	q->tail = 0;
 	q->count = 0;
+	wait_queue_init(&q->senders);
+	wait_queue_init(&q->receivers);
 }
 
-int32_t queue_send(message_queue_t *q, message_t message)
+/* --- Queue helpers (interrupts must be disabled) --- */
+
+static int32_t try_send(message_queue_t *q, message_t message)
 {
-	__disable_irq();
+	if (q->receivers.head != NULL) {
+		// Receivers only wait on an empty queue, so skip the buffer
+		tcb_t *receiver = remove_from_wait_list(&q->receivers);
+		receiver->wait_message = message;
+		TRACE_EVENT(TRACE_QUEUE_SEND, current_tcb, q->count);
+		wake_task(receiver);
+		return 0;
+	}
 
 	if (q->count >= QUEUE_MAX_MESSAGES) { // Queue is full
-		__enable_irq();
 		return -1;
 	}
 
 	q->buffer[q->tail] = message;
 	q->tail = (q->tail + 1) % QUEUE_MAX_MESSAGES;
 	q->count++;
-
-	__enable_irq();
+	TRACE_EVENT(TRACE_QUEUE_SEND, current_tcb, q->count);
 	return 0;
 }
 
-int32_t queue_receive(message_queue_t *q, message_t *message)
+static int32_t try_receive(message_queue_t *q, message_t *message)
 {
-	__disable_irq();
-
 	if (q->count == 0) { // Queue is empty
-		__enable_irq();
 		return -1;
 	}
 
 	*message = q->buffer[q->head];
 	q->head = (q->head + 1) % QUEUE_MAX_MESSAGES;
-	q->count--;
 
-	__enable_irq();
+	if (q->senders.head != NULL) {
+		// Senders only wait on a full queue: refill the freed slot
+		tcb_t *sender = remove_from_wait_list(&q->senders);
+		q->buffer[q->tail] = sender->wait_message;
+		q->tail = (q->tail + 1) % QUEUE_MAX_MESSAGES;
+		wake_task(sender);
+	} else {
+		q->count--;
+	}
+	TRACE_EVENT(TRACE_QUEUE_RECEIVE, current_tcb, q->count);
+	return 0;
+}
+
+static void copy_messages(message_t *dest, const message_t *src,
+			  uint32_t count)
+{
+	while (count-- > 0) {
+		*dest++ = *src++;
+	}
+}
+
+static uint32_t send_batch(message_queue_t *q, const message_t *messages,
+			   uint32_t count)
+{
+	uint32_t sent = 0;
+
+	// Receivers only wait on an empty queue: give each one message first
+	while (sent < count && q->receivers.head != NULL) {
+		tcb_t *receiver = remove_from_wait_list(&q->receivers);
+		receiver->wait_message = messages[sent++];
+		wake_task(receiver);
+	}
+
+	uint32_t n = QUEUE_MAX_MESSAGES - q->count;
+	if (n > count - sent) {
+		n = count - sent;
+	}
+	uint32_t first = QUEUE_MAX_MESSAGES - q->tail;
+	if (first > n) {
+		first = n;
+	}
+	copy_messages(&q->buffer[q->tail], messages + sent, first);
+	copy_messages(q->buffer, messages + sent + first, n - first);
+	q->tail = (q->tail + n) % QUEUE_MAX_MESSAGES;
+	q->count += n;
+	sent += n;
+
+	TRACE_EVENT(TRACE_QUEUE_SEND, current_tcb, q->count);
+	return sent;
+}
+
+static uint32_t receive_batch(message_queue_t *q, message_t *messages,
+			      uint32_t max)
+{
+	uint32_t n = (q->count < max) ? q->count : max;
+	uint32_t first = QUEUE_MAX_MESSAGES - q->head;
+
+	if (first > n) {
+		first = n;
+	}
+	copy_messages(messages, &q->buffer[q->head], first);
+	copy_messages(messages + first, q->buffer, n - first);
+	q->head = (q->head + n) % QUEUE_MAX_MESSAGES;
+	q->count -= n;
+
+	// Refill the freed slots from blocked senders, waking each one once
+	while (q->senders.head != NULL && q->count < QUEUE_MAX_MESSAGES) {
+		tcb_t *sender = remove_from_wait_list(&q->senders);
+		q->buffer[q->tail] = sender->wait_message;
+		q->tail = (q->tail + 1) % QUEUE_MAX_MESSAGES;
+		q->count++;
+		wake_task(sender);
+	}
+
+	TRACE_EVENT(TRACE_QUEUE_RECEIVE, current_tcb, q->count);
+	return n;
+}
+
+/* --- Public API --- */
+
+int32_t queue_send(message_queue_t *q, message_t message)
+{
+	return queue_send_timeout(q, message, TUSK_NO_WAIT);
+}
+
+int32_t queue_send_timeout(message_queue_t *q, message_t message,
+			   uint32_t timeout)
+{
+	port_disable_interrupts();
+
+	if (try_send(q, message) == 0) {
+		port_enable_interrupts();
+		return 0;
+	}
+
+	TRACE_EVENT(TRACE_QUEUE_FULL, current_tcb, TRACE_OBJECT(q));
+	if (timeout == TUSK_NO_WAIT) {
+		port_enable_interrupts();
+		return -1;
+	}
+
+	// The receiver that frees a slot queues our message and wakes us
+	current_tcb->wait_message = message;
+	block_current_task_timeout(timeout);
+	add_to_wait_list(&q->senders, current_tcb);
+	port_enable_interrupts();
+	trigger_context_switch();
+
+	return current_tcb->timed_out ? -1 : 0;
+}
+
+int32_t queue_send_from_isr(message_queue_t *q, message_t message)
+{
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	int32_t result = try_send(q, message);
+
+	if (result != 0) {
+		TRACE_EVENT(TRACE_QUEUE_FULL, current_tcb, TRACE_OBJECT(q));
+	}
+	port_clear_interrupt_mask_from_isr(mask);
+	return result;
+}
+
+uint32_t queue_send_many(message_queue_t *q, const message_t *messages,
+			 uint32_t count)
+{
+	return queue_send_many_timeout(q, messages, count, TUSK_NO_WAIT);
+}
+
+uint32_t queue_send_many_timeout(message_queue_t *q, const message_t *messages,
+				 uint32_t count, uint32_t timeout)
+{
+	uint32_t start = rtos_ticks;
+	uint32_t sent;
+
+	port_disable_interrupts();
+	sent = send_batch(q, messages, count);
+
+	while (sent < count && timeout != TUSK_NO_WAIT) {
+		uint32_t wait = timeout;
+
+		// Every time we block counts against the same timeout
+		if (timeout != TUSK_WAIT_FOREVER) {
+			uint32_t elapsed = rtos_ticks - start;
+			if (elapsed >= timeout) {
+				break;
+			}
+			wait = timeout - elapsed;
+		}
+
+		// The receiver queues our next message and wakes us once
+		TRACE_EVENT(TRACE_QUEUE_FULL, current_tcb, TRACE_OBJECT(q));
+		current_tcb->wait_message = messages[sent];
+		block_current_task_timeout(wait);
+		add_to_wait_list(&q->senders, current_tcb);
+		port_enable_interrupts();
+		trigger_context_switch();
+		port_disable_interrupts();
+
+		if (current_tcb->timed_out) {
+			break;
+		}
+		sent++;
+		sent += send_batch(q, messages + sent, count - sent);
+	}
+
+	port_enable_interrupts();
+	return sent;
+}
+
+int32_t queue_receive(message_queue_t *q, message_t *message)
+{
+	return queue_receive_timeout(q, message, TUSK_NO_WAIT);
+}
+
+int32_t queue_receive_timeout(message_queue_t *q, message_t *message,
+			      uint32_t timeout)
+{
+	port_disable_interrupts();
+
+	if (try_receive(q, message) == 0) {
+		port_enable_interrupts();
+		return 0;
+	}
+
+	TRACE_EVENT(TRACE_QUEUE_EMPTY, current_tcb, TRACE_OBJECT(q));
+	if (timeout == TUSK_NO_WAIT) {
+		port_enable_interrupts();
+		return -1;
+	}
+
+	// The sender hands its message straight to us and wakes us
+	block_current_task_timeout(timeout);
+	add_to_wait_list(&q->receivers, current_tcb);
+	port_enable_interrupts();
+	trigger_context_switch();
+
+	if (current_tcb->timed_out) {
+		return -1;
+	}
+	*message = current_tcb->wait_message;
 	return 0;
 }
+
+uint32_t queue_receive_many(message_queue_t *q, message_t *messages,
+			    uint32_t max)
+{
+	return queue_receive_many_timeout(q, messages, max, TUSK_NO_WAIT);
+}
+
+uint32_t queue_receive_many_timeout(message_queue_t *q, message_t *messages,
+				    uint32_t max, uint32_t timeout)
+{
+	uint32_t received;
+
+	if (max == 0) {
+		return 0;
+	}
+
+	port_disable_interrupts();
+	received = receive_batch(q, messages, max);
+	if (received == 0 && timeout != TUSK_NO_WAIT) {
+		// The sender hands us its first message; the rest of its
+		// batch is queued by the time we run
+		TRACE_EVENT(TRACE_QUEUE_EMPTY, current_tcb, TRACE_OBJECT(q));
+		block_current_task_timeout(timeout);
+		add_to_wait_list(&q->receivers, current_tcb);
+		port_enable_interrupts();
+		trigger_context_switch();
+		port_disable_interrupts();
+
+		if (!current_tcb->timed_out) {
+			messages[0] = current_tcb->wait_message;
+			received = 1 + receive_batch(q, messages + 1, max - 1);
+		}
+	}
+	port_enable_interrupts();
+	return received;
+}
+
+int32_t queue_receive_from_isr(message_queue_t *q, message_t *message)
+{
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	int32_t result = try_receive(q, message);
+
+	if (result != 0) {
+		TRACE_EVENT(TRACE_QUEUE_EMPTY, current_tcb, TRACE_OBJECT(q));
+	}
+	port_clear_interrupt_mask_from_isr(mask);
+	return result;
+}
@@ -1,6 +1,7 @@
 #include "../include/tusk.h"
 #include "../include/sync.h"
 #include "../include/serial.h"
+#include "../include/trace.h"
 
 tusk_mutex_t uart_mutex;
 
@@ -27,6 +28,19 @@ void task2_handler(void)
 	}
 }
 
+#if TUSK_USE_TRACE
+// Sends the scheduler trace over the UART, see tools/trace2perfetto.py
+void trace_task_handler(void)
+{
+	while (1) {
+		tusk_mutex_acquire(&uart_mutex);
+		tusk_trace_drain();
+		tusk_mutex_release(&uart_mutex);
+		tusk_delay(100);
+	}
+}
+#endif
+
 int main(void)
 {
 	// Initialize hardware (clocks, UART, etc.)
@@ -37,8 +51,11 @@ int main(void)
 	tusk_mutex_init(&uart_mutex);
 
 	// Create the tasks
-	tusk_create_task(task1_handler);
-	tusk_create_task(task2_handler);
+	tusk_create_task(task1_handler, 1, 1024);
+	tusk_create_task(task2_handler, 1, 1024);
+#if TUSK_USE_TRACE
+	tusk_create_task(trace_task_handler, 2, 1024);
+#endif
 
 	// Start the RTOS scheduler
 	// This function will not return.
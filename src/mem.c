@@ -1,4 +1,6 @@
 #include "../include/mem.h"
+#include "../include/port.h"
+#include "../include/kernel.h"
 
 // TODO: Replace commented asserts
 
@@ -15,6 +17,44 @@ static inline size_t align_up(size_t size)
 	return (size + (ALIGNMENT_BYTES - 1)) & ~(ALIGNMENT_BYTES - 1);
 }
 
+/**
+ * @brief Counts `count` more used blocks and raises the peak if needed.
+ */
+static void count_alloc(mem_pool_t *pool, uint32_t count)
+{
+	uint32_t used = port_atomic_add(&pool->used_blocks, count) + count;
+
+	for (uint32_t peak = pool->peak_blocks; used > peak;
+	     peak = pool->peak_blocks) {
+		if (port_atomic_cas(&pool->peak_blocks, peak, used)) {
+			break;
+		}
+	}
+}
+
+#if TUSK_MEM_POOL_LOCK_FREE
+// The free-list head packs a change counter above a block link. The counter
+// changes on every push and pop, so a compare-and-swap that raced with
+// other allocations fails even if the same block is back at the head (ABA).
+#define FREE_LINK_MASK 0xFFFFUL
+#define FREE_TAG_STEP 0x10000UL
+
+/**
+ * @brief Returns the block a free-list link (index + 1) refers to.
+ */
+static inline uint8_t *link_to_block(const mem_pool_t *pool, uint32_t link)
+{
+	return pool->pool_start + (size_t)(link - 1) * pool->block_size;
+}
+
+static inline uint32_t block_to_link(const mem_pool_t *pool, const void *block)
+{
+	return (uint32_t)(((const uint8_t *)block - pool->pool_start) /
+			  pool->block_size) +
+	       1;
+}
+#endif
+
 bool mem_pool_init(mem_pool_t *pool, void *pool_buffer, size_t pool_size,
 		   size_t block_size)
 {
@@ -37,12 +77,27 @@ bool mem_pool_init(mem_pool_t *pool, void *pool_buffer, size_t pool_size,
 	if (num_blocks == 0) {
 		return false; // Pool buffer is too small to even hold one block.
 	}
+#if TUSK_MEM_POOL_LOCK_FREE
+	if (num_blocks > MEM_POOL_MAX_BLOCKS) {
+		num_blocks = MEM_POOL_MAX_BLOCKS; // Links are only 16 bits wide
+	}
+#endif
 
 	// 3. Initialize the pool control block.
 	pool->pool_start = (uint8_t *)pool_buffer;
 	pool->num_blocks = num_blocks;
 	pool->block_size = actual_block_size;
 	pool->used_blocks = 0;
+	pool->peak_blocks = 0;
+
+#if TUSK_MEM_POOL_LOCK_FREE
+	// 4. Link every block to the next one by index, the last one to none.
+	for (uint32_t link = 1; link < num_blocks; ++link) {
+		*(uint32_t *)link_to_block(pool, link) = link + 1;
+	}
+	*(uint32_t *)link_to_block(pool, (uint32_t)num_blocks) = 0;
+	pool->free_head = 1;
+#else
 	tusk_mutex_init(&pool->mutex);
 
 	// 4. Create the singly-linked list of free blocks.
@@ -60,6 +115,7 @@ bool mem_pool_init(mem_pool_t *pool, void *pool_buffer, size_t pool_size,
 
 	// 6. The head of the free list is the first block in the pool.
 	pool->next_free_block = (void **)pool->pool_start;
+#endif
 
 	return true;
 }
@@ -71,17 +127,125 @@ void mem_pool_deinit(mem_pool_t *pool)
 	}
 	// For safety, you might want to assert that all blocks have been freed.
 	// assert(pool->used_blocks == 0);
+#if !TUSK_MEM_POOL_LOCK_FREE
 	tusk_mutex_release(&pool->mutex); // TODO deinit the mutex
+#endif
 
 	// Clear the structure to prevent accidental use-after-free
 	pool->pool_start = NULL;
+#if TUSK_MEM_POOL_LOCK_FREE
+	pool->free_head = 0;
+#else
 	pool->next_free_block = NULL;
+#endif
 	pool->num_blocks = 0;
 	pool->block_size = 0;
 	pool->used_blocks = 0;
+	pool->peak_blocks = 0;
 	// pool->mutex = NULL;
 }
 
+#if TUSK_MEM_POOL_LOCK_FREE
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+	uint32_t head;
+	uint8_t *block;
+
+	if (pool == NULL) {
+		return NULL;
+	}
+
+	do {
+		head = pool->free_head;
+		if ((head & FREE_LINK_MASK) == 0) {
+			return NULL; // Pool is exhausted.
+		}
+		// If someone else takes this block first, the link read here may
+		// be garbage, but then the tag has moved on and the swap fails.
+		block = link_to_block(pool, head & FREE_LINK_MASK);
+	} while (!port_atomic_cas(&pool->free_head, head,
+				  ((head + FREE_TAG_STEP) & ~FREE_LINK_MASK) |
+					  *(volatile uint32_t *)block));
+
+	count_alloc(pool, 1);
+	return block;
+}
+
+void mem_pool_free(mem_pool_t *pool, void *block)
+{
+	uint32_t link;
+	uint32_t head;
+
+	if (pool == NULL || block == NULL) {
+		return;
+	}
+
+	link = block_to_link(pool, block);
+	do {
+		head = pool->free_head;
+		*(volatile uint32_t *)block = head & FREE_LINK_MASK;
+	} while (!port_atomic_cas(&pool->free_head, head,
+				  ((head + FREE_TAG_STEP) & ~FREE_LINK_MASK) |
+					  link));
+
+	port_atomic_add(&pool->used_blocks, (uint32_t)-1);
+}
+
+size_t mem_pool_alloc_many(mem_pool_t *pool, void **blocks, size_t count)
+{
+	size_t taken = 0;
+
+	if (pool == NULL || blocks == NULL) {
+		return 0;
+	}
+
+	// A batch cannot be popped at once: its links may change under us
+	while (taken < count) {
+		uint32_t head;
+		uint8_t *block;
+
+		do {
+			head = pool->free_head;
+			if ((head & FREE_LINK_MASK) == 0) {
+				goto exhausted;
+			}
+			block = link_to_block(pool, head & FREE_LINK_MASK);
+		} while (!port_atomic_cas(&pool->free_head, head,
+					  ((head + FREE_TAG_STEP) &
+					   ~FREE_LINK_MASK) |
+						  *(volatile uint32_t *)block));
+		blocks[taken++] = block;
+	}
+
+exhausted:
+	if (taken > 0) {
+		count_alloc(pool, (uint32_t)taken);
+	}
+	return taken;
+}
+
+void mem_pool_free_many(mem_pool_t *pool, void *const *blocks, size_t count)
+{
+	uint32_t head;
+
+	if (pool == NULL || blocks == NULL || count == 0) {
+		return;
+	}
+
+	// Chain the batch privately, then splice it in front of the list
+	for (size_t i = 0; i + 1 < count; i++) {
+		*(volatile uint32_t *)blocks[i] = block_to_link(pool, blocks[i + 1]);
+	}
+	do {
+		head = pool->free_head;
+		*(volatile uint32_t *)blocks[count - 1] = head & FREE_LINK_MASK;
+	} while (!port_atomic_cas(&pool->free_head, head,
+				  ((head + FREE_TAG_STEP) & ~FREE_LINK_MASK) |
+					  block_to_link(pool, blocks[0])));
+
+	port_atomic_add(&pool->used_blocks, (uint32_t)-count);
+}
+#else
 void *mem_pool_alloc(mem_pool_t *pool)
 {
 	// assert(pool != NULL);
@@ -104,7 +268,7 @@ void *mem_pool_alloc(mem_pool_t *pool)
 	// The pointer to the next block is stored in the memory of the current free block.
 	pool->next_free_block = *(void **)allocated_block;
 
-	pool->used_blocks++;
+	count_alloc(pool, 1);
 
 	tusk_mutex_release(&pool->mutex);
 
@@ -140,6 +304,43 @@ void mem_pool_free(mem_pool_t *pool, void *block)
 	tusk_mutex_release(&pool->mutex);
 }
 
+size_t mem_pool_alloc_many(mem_pool_t *pool, void **blocks, size_t count)
+{
+	size_t taken = 0;
+
+	if (pool == NULL || blocks == NULL) {
+		return 0;
+	}
+
+	tusk_mutex_acquire(&pool->mutex);
+	while (taken < count && pool->next_free_block != NULL) {
+		blocks[taken++] = pool->next_free_block;
+		pool->next_free_block = *(void **)pool->next_free_block;
+	}
+	if (taken > 0) {
+		count_alloc(pool, (uint32_t)taken);
+	}
+	tusk_mutex_release(&pool->mutex);
+
+	return taken;
+}
+
+void mem_pool_free_many(mem_pool_t *pool, void *const *blocks, size_t count)
+{
+	if (pool == NULL || blocks == NULL || count == 0) {
+		return;
+	}
+
+	tusk_mutex_acquire(&pool->mutex);
+	for (size_t i = 0; i < count; i++) {
+		*(void **)blocks[i] = pool->next_free_block;
+		pool->next_free_block = (void **)blocks[i];
+	}
+	pool->used_blocks -= (uint32_t)count;
+	tusk_mutex_release(&pool->mutex);
+}
+#endif
+
 size_t mem_pool_get_used_count(mem_pool_t *pool)
 {
 	// This is a quick, non-locking read. For a perfectly accurate number
@@ -147,3 +348,654 @@ size_t mem_pool_get_used_count(mem_pool_t *pool)
 	// this is sufficient for diagnostics.
 	return (pool != NULL) ? pool->used_blocks : 0;
 }
+
+size_t mem_pool_get_peak_count(mem_pool_t *pool)
+{
+	return (pool != NULL) ? pool->peak_blocks : 0;
+}
+
+/* --- Per-Task Pool Caches --- */
+
+#if TUSK_MEM_POOL_CACHE_BATCH < 1 || \
+	TUSK_MEM_POOL_CACHE_BATCH > TUSK_MEM_POOL_CACHE_SIZE
+#error "TUSK_MEM_POOL_CACHE_BATCH must be between 1 and TUSK_MEM_POOL_CACHE_SIZE"
+#endif
+
+bool mem_pool_cache_init(mem_pool_cache_t *cache, mem_pool_t *pool)
+{
+	tcb_t *self = tusk_current_task();
+
+	if (cache == NULL || pool == NULL || self == NULL) {
+		return false;
+	}
+
+	cache->pool = pool;
+	cache->owner = self;
+	cache->count = 0;
+	cache->busy = 0;
+
+	// The list is only walked by tusk_delete_task(), possibly from another task
+	port_disable_interrupts();
+	cache->next = self->pool_caches;
+	self->pool_caches = cache;
+	port_enable_interrupts();
+	return true;
+}
+
+void mem_pool_cache_deinit(mem_pool_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	mem_pool_cache_flush(cache);
+	if (cache->owner == NULL) {
+		return; // Already detached by tusk_delete_task()
+	}
+
+	port_disable_interrupts();
+	mem_pool_cache_t **link = &cache->owner->pool_caches;
+	while (*link != NULL && *link != cache) {
+		link = &(*link)->next;
+	}
+	if (*link != NULL) {
+		*link = cache->next;
+	}
+	port_enable_interrupts();
+
+	cache->owner = NULL;
+	cache->next = NULL;
+}
+
+void *mem_pool_cache_alloc(mem_pool_cache_t *cache)
+{
+	void *block = NULL;
+
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	// Keeps tusk_delete_task() from flushing the cache under our feet
+	cache->busy = 1;
+	port_memory_barrier();
+	if (cache->count == 0) {
+		cache->count = mem_pool_alloc_many(cache->pool, cache->blocks,
+						   TUSK_MEM_POOL_CACHE_BATCH);
+	}
+	if (cache->count != 0) {
+		block = cache->blocks[--cache->count];
+	}
+	port_memory_barrier();
+	cache->busy = 0;
+	return block;
+}
+
+void mem_pool_cache_free(mem_pool_cache_t *cache, void *block)
+{
+	if (cache == NULL || block == NULL) {
+		return;
+	}
+
+	cache->busy = 1;
+	port_memory_barrier();
+	if (cache->count == TUSK_MEM_POOL_CACHE_SIZE) {
+		cache->count -= TUSK_MEM_POOL_CACHE_BATCH;
+		mem_pool_free_many(cache->pool, &cache->blocks[cache->count],
+				   TUSK_MEM_POOL_CACHE_BATCH);
+	}
+	cache->blocks[cache->count++] = block;
+	port_memory_barrier();
+	cache->busy = 0;
+}
+
+void mem_pool_cache_flush(mem_pool_cache_t *cache)
+{
+	if (cache == NULL) {
+		return;
+	}
+
+	cache->busy = 1;
+	port_memory_barrier();
+	mem_pool_free_many(cache->pool, cache->blocks, cache->count);
+	cache->count = 0;
+	port_memory_barrier();
+	cache->busy = 0;
+}
+
+void mem_pool_cache_flush_task(tcb_t *task)
+{
+	mem_pool_cache_t *cache = task->pool_caches;
+
+	task->pool_caches = NULL;
+	while (cache != NULL) {
+		mem_pool_cache_t *next = cache->next;
+		mem_pool_cache_flush(cache);
+		cache->owner = NULL;
+		cache->next = NULL;
+		cache = next;
+	}
+}
+
+void mem_pool_cache_detach_busy(tcb_t *task)
+{
+	mem_pool_cache_t **link = &task->pool_caches;
+
+	while (*link != NULL) {
+		mem_pool_cache_t *cache = *link;
+		if (cache->busy) {
+			// Its count and blocks may be half-updated
+			*link = cache->next;
+			cache->owner = NULL;
+			cache->next = NULL;
+		} else {
+			link = &cache->next;
+		}
+	}
+}
+
+/* --- Size-Class Allocator --- */
+
+#define SLAB_TABLE_SIZE (TUSK_SLAB_MAX_SIZE / TUSK_SLAB_GRANULE + 1)
+// Marks a table entry whose requests are larger than every class
+#define SLAB_NO_CLASS 0xFFU
+
+typedef struct {
+	mem_pool_t pool;
+	uint8_t *end; // One past the last block, for finding the owner of a block
+	volatile uint32_t allocations;
+	volatile uint32_t failures;
+} slab_class_t;
+
+// Classes sorted by block size, smallest first
+static slab_class_t slab_classes[TUSK_SLAB_MAX_CLASSES];
+static size_t slab_class_count;
+
+// Smallest class for each request size, rounded up to whole granules
+static uint8_t slab_lookup[SLAB_TABLE_SIZE];
+
+bool tusk_slab_init(const tusk_slab_class_t *classes, size_t count)
+{
+	const tusk_slab_class_t *sorted[TUSK_SLAB_MAX_CLASSES];
+
+	if (classes == NULL || count == 0 || count > TUSK_SLAB_MAX_CLASSES) {
+		return false;
+	}
+
+	// Insertion sort by block size; there are only a handful of classes
+	for (size_t i = 0; i < count; i++) {
+		size_t j = i;
+		while (j > 0 && sorted[j - 1]->block_size > classes[i].block_size) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		if (j > 0 && sorted[j - 1]->block_size == classes[i].block_size) {
+			return false;
+		}
+		sorted[j] = &classes[i];
+	}
+
+	slab_class_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		slab_class_t *slab = &slab_classes[i];
+
+		if (!mem_pool_init(&slab->pool, sorted[i]->buffer,
+				   sorted[i]->buffer_size, sorted[i]->block_size)) {
+			return false;
+		}
+		slab->end = slab->pool.pool_start +
+			    slab->pool.num_blocks * slab->pool.block_size;
+		slab->allocations = 0;
+		slab->failures = 0;
+	}
+	slab_class_count = count;
+
+	// Entry g serves requests of up to g granules
+	size_t class_index = 0;
+	for (size_t g = 0; g < SLAB_TABLE_SIZE; g++) {
+		while (class_index < count &&
+		       slab_classes[class_index].pool.block_size <
+			       g * TUSK_SLAB_GRANULE) {
+			class_index++;
+		}
+		slab_lookup[g] = (class_index < count) ? (uint8_t)class_index :
+							 SLAB_NO_CLASS;
+	}
+	return true;
+}
+
+void *tusk_malloc(size_t size)
+{
+	if (size > TUSK_SLAB_MAX_SIZE) {
+		return NULL;
+	}
+
+	uint8_t class_index =
+		slab_lookup[(size + TUSK_SLAB_GRANULE - 1) / TUSK_SLAB_GRANULE];
+	if (class_index == SLAB_NO_CLASS) {
+		return NULL;
+	}
+
+	// Spill into larger classes only when the best one is empty
+	for (size_t i = class_index; i < slab_class_count; i++) {
+		void *block = mem_pool_alloc(&slab_classes[i].pool);
+		if (block != NULL) {
+			port_atomic_add(&slab_classes[i].allocations, 1);
+			return block;
+		}
+		port_atomic_add(&slab_classes[i].failures, 1);
+	}
+	return NULL;
+}
+
+void tusk_free(void *block)
+{
+	if (block == NULL) {
+		return;
+	}
+
+	for (size_t i = 0; i < slab_class_count; i++) {
+		slab_class_t *slab = &slab_classes[i];
+		if ((uint8_t *)block >= slab->pool.pool_start &&
+		    (uint8_t *)block < slab->end) {
+			mem_pool_free(&slab->pool, block);
+			return;
+		}
+	}
+	// assert(false); // Not a tusk_malloc() block
+}
+
+size_t tusk_slab_get_stats(tusk_slab_stats_t *stats, size_t max_entries)
+{
+	size_t count = 0;
+
+	for (; count < slab_class_count && count < max_entries; count++) {
+		slab_class_t *slab = &slab_classes[count];
+
+		stats[count].block_size = slab->pool.block_size;
+		stats[count].num_blocks = slab->pool.num_blocks;
+		stats[count].used_blocks = mem_pool_get_used_count(&slab->pool);
+		stats[count].peak_blocks = mem_pool_get_peak_count(&slab->pool);
+		stats[count].allocations = slab->allocations;
+		stats[count].failures = slab->failures;
+	}
+	return count;
+}
+
+/* --- TLSF Heap --- */
+
+#if TUSK_HEAP_SL_LOG2 > 5 || TUSK_HEAP_FL_COUNT > 32 || TUSK_HEAP_FL_COUNT < 1
+#error "TUSK_HEAP_SL_LOG2 or TUSK_HEAP_MAX_BLOCK_LOG2 out of range"
+#endif
+
+// Set in the size field of a free block; sizes are multiples of 8
+#define HEAP_BLOCK_FREE 1U
+#define HEAP_SIZE_MASK (~(size_t)(TUSK_HEAP_ALIGNMENT - 1))
+
+typedef struct tusk_heap_block {
+	struct tusk_heap_block *prev_phys; // The block just below this one
+	size_t size; // Payload size in bytes, with HEAP_BLOCK_FREE
+	// Free blocks only: these overlap the payload of an allocated block
+	struct tusk_heap_block *next_free;
+	struct tusk_heap_block *prev_free;
+} heap_block_t;
+
+#define HEAP_HEADER_SIZE offsetof(heap_block_t, next_free)
+#define HEAP_MIN_PAYLOAD (sizeof(heap_block_t) - HEAP_HEADER_SIZE)
+#define HEAP_MIN_BLOCK (HEAP_HEADER_SIZE + HEAP_MIN_PAYLOAD)
+// Largest payload whose size class still has a free list
+#define HEAP_MAX_PAYLOAD \
+	(((size_t)1 << TUSK_HEAP_MAX_BLOCK_LOG2) - TUSK_HEAP_ALIGNMENT)
+
+static inline uint32_t heap_msb(uint32_t value)
+{
+	return 31U - port_clz(value);
+}
+
+static inline uint32_t heap_lsb(uint32_t value)
+{
+	return 31U - port_clz(value & (~value + 1U));
+}
+
+static inline size_t heap_block_size(const heap_block_t *block)
+{
+	return block->size & HEAP_SIZE_MASK;
+}
+
+static inline uint8_t *block_payload(heap_block_t *block)
+{
+	return (uint8_t *)block + HEAP_HEADER_SIZE;
+}
+
+static inline heap_block_t *payload_block(void *payload)
+{
+	return (heap_block_t *)((uint8_t *)payload - HEAP_HEADER_SIZE);
+}
+
+static inline heap_block_t *block_next(heap_block_t *block)
+{
+	return (heap_block_t *)(block_payload(block) + heap_block_size(block));
+}
+
+/**
+ * @brief Finds the free list a block of `size` payload bytes belongs on.
+ */
+static void heap_mapping(size_t size, uint32_t *fl, uint32_t *sl)
+{
+	if (size < (1U << TUSK_HEAP_FL_SHIFT)) {
+		// Below the first power-of-two range the lists are linear
+		*fl = 0;
+		*sl = (uint32_t)size / TUSK_HEAP_ALIGNMENT;
+	} else {
+		uint32_t msb = heap_msb((uint32_t)size);
+		*fl = msb - TUSK_HEAP_FL_SHIFT + 1;
+		*sl = ((uint32_t)size >> (msb - TUSK_HEAP_SL_LOG2)) ^
+		      TUSK_HEAP_SL_COUNT;
+	}
+}
+
+static void heap_insert(tusk_heap_t *heap, heap_block_t *block)
+{
+	uint32_t fl, sl;
+
+	heap_mapping(heap_block_size(block), &fl, &sl);
+	block->size |= HEAP_BLOCK_FREE;
+	block->prev_free = NULL;
+	block->next_free = heap->free_lists[fl][sl];
+	if (block->next_free != NULL) {
+		block->next_free->prev_free = block;
+	}
+	heap->free_lists[fl][sl] = block;
+	heap->fl_bitmap |= 1U << fl;
+	heap->sl_bitmap[fl] |= 1U << sl;
+	heap->free_bytes += heap_block_size(block);
+	heap->free_blocks++;
+}
+
+static void heap_remove(tusk_heap_t *heap, heap_block_t *block)
+{
+	uint32_t fl, sl;
+
+	heap_mapping(heap_block_size(block), &fl, &sl);
+	if (block->prev_free != NULL) {
+		block->prev_free->next_free = block->next_free;
+	} else {
+		heap->free_lists[fl][sl] = block->next_free;
+		if (block->next_free == NULL) {
+			heap->sl_bitmap[fl] &= ~(1U << sl);
+			if (heap->sl_bitmap[fl] == 0) {
+				heap->fl_bitmap &= ~(1U << fl);
+			}
+		}
+	}
+	if (block->next_free != NULL) {
+		block->next_free->prev_free = block->prev_free;
+	}
+	block->size &= ~(size_t)HEAP_BLOCK_FREE;
+	heap->free_bytes -= heap_block_size(block);
+	heap->free_blocks--;
+}
+
+/**
+ * @brief Takes a free block of at least `size` bytes off its list, or returns NULL.
+ *
+ * The request is rounded up to the next list boundary first, so that every
+ * block on the list found is large enough and no list has to be searched.
+ */
+static heap_block_t *heap_take(tusk_heap_t *heap, size_t size)
+{
+	uint32_t fl, sl;
+
+	if (size >= (1U << TUSK_HEAP_FL_SHIFT)) {
+		size += (1U << (heap_msb((uint32_t)size) - TUSK_HEAP_SL_LOG2)) -
+			1U;
+	}
+	heap_mapping(size, &fl, &sl);
+	if (fl >= TUSK_HEAP_FL_COUNT) {
+		return NULL;
+	}
+
+	uint32_t sl_map = heap->sl_bitmap[fl] & (~0U << sl);
+	if (sl_map == 0) {
+		// Nothing left in this range, take the smallest larger one
+		uint32_t fl_map = (fl + 1 < 32) ?
+					  heap->fl_bitmap & (~0U << (fl + 1)) :
+					  0;
+		if (fl_map == 0) {
+			return NULL;
+		}
+		fl = heap_lsb(fl_map);
+		sl_map = heap->sl_bitmap[fl];
+	}
+	sl = heap_lsb(sl_map);
+
+	heap_block_t *block = heap->free_lists[fl][sl];
+	heap_remove(heap, block);
+	return block;
+}
+
+/**
+ * @brief Returns the end of a block beyond `size` bytes to the heap if it is big enough.
+ */
+static void heap_trim(tusk_heap_t *heap, heap_block_t *block, size_t size)
+{
+	if (heap_block_size(block) < size + HEAP_MIN_BLOCK) {
+		return;
+	}
+
+	heap_block_t *rest = (heap_block_t *)(block_payload(block) + size);
+	rest->prev_phys = block;
+	rest->size = heap_block_size(block) - size - HEAP_HEADER_SIZE;
+	block_next(rest)->prev_phys = rest;
+	block->size = size;
+	heap_insert(heap, rest);
+}
+
+/**
+ * @brief Rounds a request up to a valid payload size, or returns 0 if it is too large.
+ */
+static size_t heap_adjust(size_t size)
+{
+	if (size > HEAP_MAX_PAYLOAD) {
+		return 0;
+	}
+	size = (size + TUSK_HEAP_ALIGNMENT - 1) & HEAP_SIZE_MASK;
+	return (size < HEAP_MIN_PAYLOAD) ? HEAP_MIN_PAYLOAD : size;
+}
+
+static void heap_count_alloc(tusk_heap_t *heap, heap_block_t *block)
+{
+	heap->used_bytes += heap_block_size(block);
+	if (heap->used_bytes > heap->peak_used_bytes) {
+		heap->peak_used_bytes = heap->used_bytes;
+	}
+	heap->used_blocks++;
+	heap->allocations++;
+}
+
+bool tusk_heap_init(tusk_heap_t *heap, void *region, size_t region_size)
+{
+	if (heap == NULL || region == NULL) {
+		return false;
+	}
+
+	// Align the start; the end needs room for a zero-sized sentinel block
+	uintptr_t start = ((uintptr_t)region + TUSK_HEAP_ALIGNMENT - 1) &
+			  ~(uintptr_t)(TUSK_HEAP_ALIGNMENT - 1);
+	uintptr_t end = ((uintptr_t)region + region_size) &
+			~(uintptr_t)(TUSK_HEAP_ALIGNMENT - 1);
+	if (end < start + HEAP_MIN_BLOCK + HEAP_HEADER_SIZE) {
+		return false;
+	}
+	size_t payload = end - start - 2 * HEAP_HEADER_SIZE;
+	if (payload > HEAP_MAX_PAYLOAD) {
+		payload = HEAP_MAX_PAYLOAD;
+	}
+
+	for (uint32_t fl = 0; fl < TUSK_HEAP_FL_COUNT; fl++) {
+		for (uint32_t sl = 0; sl < TUSK_HEAP_SL_COUNT; sl++) {
+			heap->free_lists[fl][sl] = NULL;
+		}
+		heap->sl_bitmap[fl] = 0;
+	}
+	heap->fl_bitmap = 0;
+	heap->total_bytes = payload + 2 * HEAP_HEADER_SIZE;
+	heap->used_bytes = 0;
+	heap->peak_used_bytes = 0;
+	heap->free_bytes = 0;
+	heap->used_blocks = 0;
+	heap->free_blocks = 0;
+	heap->allocations = 0;
+	heap->failures = 0;
+	tusk_mutex_init(&heap->mutex);
+
+	// One free block spanning the region, then a permanently allocated
+	// sentinel so that merging never runs off the end.
+	heap_block_t *block = (heap_block_t *)start;
+	block->prev_phys = NULL;
+	block->size = payload;
+	heap_block_t *sentinel = block_next(block);
+	sentinel->prev_phys = block;
+	sentinel->size = 0;
+	heap_insert(heap, block);
+	return true;
+}
+
+void *tusk_heap_malloc(tusk_heap_t *heap, size_t size)
+{
+	if (heap == NULL || size == 0) {
+		return NULL;
+	}
+	size = heap_adjust(size);
+	if (size == 0) {
+		return NULL;
+	}
+
+	tusk_mutex_acquire(&heap->mutex);
+	heap_block_t *block = heap_take(heap, size);
+	if (block == NULL) {
+		heap->failures++;
+		tusk_mutex_release(&heap->mutex);
+		return NULL;
+	}
+	heap_trim(heap, block, size);
+	heap_count_alloc(heap, block);
+	tusk_mutex_release(&heap->mutex);
+
+	return block_payload(block);
+}
+
+void *tusk_heap_malloc_aligned(tusk_heap_t *heap, size_t size,
+			       size_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		return NULL;
+	}
+	if (alignment <= TUSK_HEAP_ALIGNMENT) {
+		return tusk_heap_malloc(heap, size);
+	}
+	if (heap == NULL || size == 0) {
+		return NULL;
+	}
+	size = heap_adjust(size);
+	if (size == 0 || alignment > HEAP_MAX_PAYLOAD) {
+		return NULL;
+	}
+
+	// Room for the worst-case gap in front of the aligned payload, which
+	// has to be large enough to become a free block of its own.
+	tusk_mutex_acquire(&heap->mutex);
+	heap_block_t *block = heap_take(heap, size + alignment + HEAP_MIN_BLOCK);
+	if (block == NULL) {
+		heap->failures++;
+		tusk_mutex_release(&heap->mutex);
+		return NULL;
+	}
+
+	uintptr_t payload = (uintptr_t)block_payload(block);
+	uintptr_t aligned = (payload + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if (aligned != payload && aligned - payload < HEAP_MIN_BLOCK) {
+		aligned = (payload + HEAP_MIN_BLOCK + alignment - 1) &
+			  ~(uintptr_t)(alignment - 1);
+	}
+	if (aligned != payload) {
+		// Split the gap off the front and give it back
+		heap_block_t *front = block;
+		block = payload_block((void *)aligned);
+		block->prev_phys = front;
+		block->size = heap_block_size(front) - (aligned - payload);
+		block_next(block)->prev_phys = block;
+		front->size = aligned - payload - HEAP_HEADER_SIZE;
+		heap_insert(heap, front);
+	}
+	heap_trim(heap, block, size);
+	heap_count_alloc(heap, block);
+	tusk_mutex_release(&heap->mutex);
+
+	return (void *)aligned;
+}
+
+void tusk_heap_free(tusk_heap_t *heap, void *block)
+{
+	if (heap == NULL || block == NULL) {
+		return;
+	}
+
+	heap_block_t *freed = payload_block(block);
+
+	tusk_mutex_acquire(&heap->mutex);
+	heap->used_bytes -= heap_block_size(freed);
+	heap->used_blocks--;
+
+	// Merge with the free neighbours on both sides
+	heap_block_t *prev = freed->prev_phys;
+	if (prev != NULL && (prev->size & HEAP_BLOCK_FREE)) {
+		heap_remove(heap, prev);
+		prev->size += HEAP_HEADER_SIZE + heap_block_size(freed);
+		freed = prev;
+		block_next(freed)->prev_phys = freed;
+	}
+	heap_block_t *next = block_next(freed);
+	if (next->size & HEAP_BLOCK_FREE) {
+		heap_remove(heap, next);
+		freed->size += HEAP_HEADER_SIZE + heap_block_size(next);
+		block_next(freed)->prev_phys = freed;
+	}
+	heap_insert(heap, freed);
+	tusk_mutex_release(&heap->mutex);
+}
+
+void tusk_heap_get_stats(tusk_heap_t *heap, tusk_heap_stats_t *stats)
+{
+	size_t largest = 0;
+
+	if (heap == NULL || stats == NULL) {
+		return;
+	}
+
+	tusk_mutex_acquire(&heap->mutex);
+	if (heap->fl_bitmap != 0) {
+		// The largest block is on the highest non-empty list
+		uint32_t fl = heap_msb(heap->fl_bitmap);
+		uint32_t sl = heap_msb(heap->sl_bitmap[fl]);
+		for (heap_block_t *block = heap->free_lists[fl][sl];
+		     block != NULL; block = block->next_free) {
+			if (heap_block_size(block) > largest) {
+				largest = heap_block_size(block);
+			}
+		}
+	}
+	stats->total_bytes = heap->total_bytes;
+	stats->used_bytes = heap->used_bytes;
+	stats->peak_used_bytes = heap->peak_used_bytes;
+	stats->free_bytes = heap->free_bytes;
+	stats->largest_free_block = largest;
+	stats->used_blocks = heap->used_blocks;
+	stats->free_blocks = heap->free_blocks;
+	stats->allocations = heap->allocations;
+	stats->failures = heap->failures;
+	stats->fragmentation =
+		(heap->free_bytes != 0) ?
+			(uint8_t)(100 - largest * 100 / heap->free_bytes) :
+			0;
+	tusk_mutex_release(&heap->mutex);
+}
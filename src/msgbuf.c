@@ -0,0 +1,65 @@
+#include "../include/msgbuf.h"
+#include "../include/kernel.h"
+
+tusk_msgbuf_t *tusk_msgbuf_alloc(mem_pool_t *pool)
+{
+	tusk_msgbuf_t *buf;
+
+	if (pool == NULL || pool->block_size <= sizeof(tusk_msgbuf_t)) {
+		return NULL;
+	}
+
+	buf = mem_pool_alloc(pool);
+	if (buf != NULL) {
+		buf->pool = pool;
+		buf->refs = 1;
+		buf->length = 0;
+	}
+	return buf;
+}
+
+tusk_msgbuf_t *tusk_msgbuf_ref(tusk_msgbuf_t *buf)
+{
+	port_atomic_add(&buf->refs, 1);
+	return buf;
+}
+
+void tusk_msgbuf_unref(tusk_msgbuf_t *buf)
+{
+	// Only the holder that drops the count to zero may touch the buffer
+	if (port_atomic_add(&buf->refs, (uint32_t)-1) == 1) {
+		mem_pool_free(buf->pool, buf);
+	}
+}
+
+int tusk_msgbuf_send(message_queue_t *q, tusk_msgbuf_t *buf, uint32_t timeout)
+{
+	return queue_send_timeout(q, buf, timeout);
+}
+
+tusk_msgbuf_t *tusk_msgbuf_receive(message_queue_t *q, uint32_t timeout)
+{
+	message_t message;
+
+	if (queue_receive_timeout(q, &message, timeout) != 0) {
+		return NULL;
+	}
+	return message;
+}
+
+uint32_t tusk_msgbuf_broadcast(message_queue_t *const *queues, uint32_t count,
+			       tusk_msgbuf_t *buf, uint32_t timeout)
+{
+	uint32_t delivered = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		// Take the receiver's reference before it can drop it
+		tusk_msgbuf_ref(buf);
+		if (queue_send_timeout(queues[i], buf, timeout) == 0) {
+			delivered++;
+		} else {
+			tusk_msgbuf_unref(buf);
+		}
+	}
+	return delivered;
+}
@@ -0,0 +1,109 @@
+#include "../include/ring.h"
+#include <stddef.h> // For NULL
+
+// The kernel is linked without a C library, so it brings its own copy loop
+static void copy_bytes(uint8_t *dest, const uint8_t *src, uint32_t len)
+{
+	while (len-- > 0) {
+		*dest++ = *src++;
+	}
+}
+
+int tusk_ring_init(tusk_ring_t *ring, uint8_t *buffer, uint32_t capacity)
+{
+	if (ring == NULL || buffer == NULL || capacity == 0 ||
+	    (capacity & (capacity - 1)) != 0) {
+		return -1;
+	}
+
+	ring->buffer = buffer;
+	ring->mask = capacity - 1;
+	ring->head = 0;
+	ring->tail = 0;
+	return 0;
+}
+
+uint32_t tusk_ring_write_span(tusk_ring_t *ring, uint8_t **span)
+{
+	uint32_t head = ring->head;
+	uint32_t offset = head & ring->mask;
+	uint32_t space = ring->mask + 1 - (head - ring->tail);
+	uint32_t to_end = ring->mask + 1 - offset;
+
+	*span = &ring->buffer[offset];
+	return (space < to_end) ? space : to_end;
+}
+
+void tusk_ring_commit(tusk_ring_t *ring, uint32_t len)
+{
+	// The data must be in place before the consumer can see it
+	port_memory_barrier();
+	ring->head += len;
+}
+
+uint32_t tusk_ring_read_span(tusk_ring_t *ring, const uint8_t **span)
+{
+	uint32_t tail = ring->tail;
+	uint32_t offset = tail & ring->mask;
+	uint32_t count = ring->head - tail;
+	uint32_t to_end = ring->mask + 1 - offset;
+
+	// Read the data only after seeing the index that published it
+	port_memory_barrier();
+	*span = &ring->buffer[offset];
+	return (count < to_end) ? count : to_end;
+}
+
+void tusk_ring_release(tusk_ring_t *ring, uint32_t len)
+{
+	// Finish reading before the producer may overwrite the data
+	port_memory_barrier();
+	ring->tail += len;
+}
+
+uint32_t tusk_ring_write(tusk_ring_t *ring, const uint8_t *data, uint32_t len)
+{
+	uint32_t head = ring->head;
+	uint32_t offset = head & ring->mask;
+	uint32_t space = ring->mask + 1 - (head - ring->tail);
+	uint32_t first;
+
+	if (len > space) {
+		len = space;
+	}
+
+	// At most two copies: up to the end of the storage, then from its start
+	first = ring->mask + 1 - offset;
+	if (first > len) {
+		first = len;
+	}
+	copy_bytes(&ring->buffer[offset], data, first);
+	copy_bytes(ring->buffer, data + first, len - first);
+
+	tusk_ring_commit(ring, len);
+	return len;
+}
+
+uint32_t tusk_ring_read(tusk_ring_t *ring, uint8_t *data, uint32_t len)
+{
+	uint32_t tail = ring->tail;
+	uint32_t offset = tail & ring->mask;
+	uint32_t count = ring->head - tail;
+	uint32_t first;
+
+	if (len > count) {
+		len = count;
+	}
+
+	// Read the data only after seeing the index that published it
+	port_memory_barrier();
+	first = ring->mask + 1 - offset;
+	if (first > len) {
+		first = len;
+	}
+	copy_bytes(data, &ring->buffer[offset], first);
+	copy_bytes(data + first, ring->buffer, len - first);
+
+	tusk_ring_release(ring, len);
+	return len;
+}
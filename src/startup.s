@@ -33,6 +33,18 @@ Reset_Handler:
     ldr r0, =_estack
     mov sp, r0
 
+    /*
+     * Grant full access to the FPU (CP10/CP11 in CPACR). On cores
+     * without an FPU, or in soft-float builds, this has no effect.
+     * Lazy stacking (FPCCR.ASPEN/LSPEN) is enabled out of reset.
+     */
+    ldr r0, =0xE000ED88
+    ldr r1, [r0]
+    orr r1, r1, #(0xF << 20)
+    str r1, [r0]
+    dsb
+    isb
+
     /*
      * For a real project, you would copy .data from FLASH to RAM
      * and zero out the .bss section here. For this simple QEMU
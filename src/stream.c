@@ -0,0 +1,174 @@
+#include "../include/stream.h"
+#include "../include/kernel.h"
+#include <stddef.h> // For NULL
+
+// Message records are a length word followed by the payload, padded to words
+#define RECORD_HEADER sizeof(uint32_t)
+#define RECORD_SIZE(len) (RECORD_HEADER + (((len) + 3U) & ~3U))
+// Length of a record that only fills the end of the storage
+#define RECORD_PADDING 0xFFFFFFFFUL
+
+/* --- Stream Buffers --- */
+
+int tusk_stream_init(tusk_stream_buffer_t *stream, uint8_t *buffer,
+		     uint32_t capacity)
+{
+	if (stream == NULL || tusk_ring_init(&stream->ring, buffer, capacity) != 0) {
+		return -1;
+	}
+	stream->trigger = 0;
+	wait_queue_init(&stream->reader);
+	return 0;
+}
+
+uint32_t tusk_stream_reserve(tusk_stream_buffer_t *stream, uint32_t len,
+			     uint8_t **data)
+{
+	uint32_t span = tusk_ring_write_span(&stream->ring, data);
+
+	return (span < len) ? span : len;
+}
+
+void tusk_stream_commit(tusk_stream_buffer_t *stream, uint32_t len)
+{
+	tusk_ring_commit(&stream->ring, len);
+
+	// The reader checks the count before it goes to sleep, so look for it
+	// only after publishing. Only pay for masking interrupts if it sleeps.
+	port_memory_barrier();
+	if (stream->reader.head != NULL) {
+		uint32_t mask = port_set_interrupt_mask_from_isr();
+		if (stream->reader.head != NULL &&
+		    tusk_ring_count(&stream->ring) >= stream->trigger) {
+			wake_task(remove_from_wait_list(&stream->reader));
+		}
+		port_clear_interrupt_mask_from_isr(mask);
+	}
+}
+
+uint32_t tusk_stream_peek(tusk_stream_buffer_t *stream, const uint8_t **data)
+{
+	return tusk_ring_read_span(&stream->ring, data);
+}
+
+void tusk_stream_release(tusk_stream_buffer_t *stream, uint32_t len)
+{
+	tusk_ring_release(&stream->ring, len);
+}
+
+int tusk_stream_wait(tusk_stream_buffer_t *stream, uint32_t len,
+		     uint32_t timeout)
+{
+	if (len > stream->ring.mask + 1) {
+		return -1;
+	}
+
+	port_disable_interrupts();
+	if (tusk_ring_count(&stream->ring) < len && timeout != TUSK_NO_WAIT) {
+		// The writer checks the trigger after every commit
+		stream->trigger = len;
+		block_current_task_timeout(timeout);
+		add_to_wait_list(&stream->reader, current_tcb);
+		port_enable_interrupts();
+		trigger_context_switch();
+		port_disable_interrupts();
+	}
+	int result = (tusk_ring_count(&stream->ring) >= len) ? 0 : -1;
+	port_enable_interrupts();
+	return result;
+}
+
+/* --- Message Buffers --- */
+
+static inline uint32_t *record_at(tusk_ring_t *ring, uint32_t index)
+{
+	return (uint32_t *)&ring->buffer[index & ring->mask];
+}
+
+int tusk_message_buffer_init(tusk_message_buffer_t *messages, uint8_t *buffer,
+			     uint32_t capacity)
+{
+	if (messages == NULL || ((uintptr_t)buffer & 3U) != 0 ||
+	    capacity < 2 * RECORD_HEADER) {
+		return -1;
+	}
+	if (tusk_stream_init(&messages->stream, buffer, capacity) != 0) {
+		return -1;
+	}
+	messages->reserved = 0;
+	messages->peeked = 0;
+	return 0;
+}
+
+void *tusk_message_reserve(tusk_message_buffer_t *messages, uint32_t len)
+{
+	tusk_ring_t *ring = &messages->stream.ring;
+	uint32_t head = ring->head;
+	uint32_t space = tusk_ring_space(ring);
+	uint32_t to_end = ring->mask + 1 - (head & ring->mask);
+	uint32_t size = RECORD_SIZE(len);
+	uint32_t skip = 0;
+
+	if (len > ring->mask + 1 - RECORD_HEADER) {
+		return NULL;
+	}
+	if (size > to_end) {
+		// The record must not wrap: pad out the end of the storage
+		skip = to_end;
+	}
+	if (skip + size > space) {
+		return NULL;
+	}
+
+	// Free space is invisible to the reader until the commit
+	if (skip != 0) {
+		*record_at(ring, head) = RECORD_PADDING;
+	}
+	messages->reserved = skip;
+	return record_at(ring, head + skip) + 1;
+}
+
+void tusk_message_commit(tusk_message_buffer_t *messages, uint32_t len)
+{
+	tusk_ring_t *ring = &messages->stream.ring;
+	uint32_t skip = messages->reserved;
+
+	*record_at(ring, ring->head + skip) = len;
+	tusk_stream_commit(&messages->stream, skip + RECORD_SIZE(len));
+}
+
+const void *tusk_message_peek(tusk_message_buffer_t *messages, uint32_t *len)
+{
+	tusk_ring_t *ring = &messages->stream.ring;
+	uint32_t tail = ring->tail;
+	uint32_t skip = 0;
+
+	if (ring->head == tail) {
+		return NULL;
+	}
+	// Read the record only after seeing the index that published it
+	port_memory_barrier();
+
+	uint32_t length = *record_at(ring, tail);
+	if (length == RECORD_PADDING) {
+		// A padded end is always committed with the record after it
+		skip = ring->mask + 1 - (tail & ring->mask);
+		length = *record_at(ring, tail + skip);
+	}
+
+	messages->peeked = skip + RECORD_SIZE(length);
+	*len = length;
+	return record_at(ring, tail + skip) + 1;
+}
+
+void tusk_message_release(tusk_message_buffer_t *messages)
+{
+	tusk_ring_release(&messages->stream.ring, messages->peeked);
+	messages->peeked = 0;
+}
+
+int tusk_message_wait(tusk_message_buffer_t *messages, uint32_t timeout)
+{
+	// Records are published whole, so any byte means a message
+	return tusk_stream_wait(&messages->stream, 1, timeout);
+}
@@ -0,0 +1,266 @@
+#include "../include/timer.h"
+#include "../include/kernel.h"
+#include <stddef.h> // For NULL
+
+#define WHEEL_SIZE (1UL << TIMER_WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+// Number of ticks covered by all wheel levels below `level`
+#define WHEEL_SPAN(level) (1UL << (TIMER_WHEEL_BITS * (level)))
+// Furthest expiry the wheel can file directly
+#define WHEEL_MAX_DELTA (WHEEL_SPAN(TIMER_WHEEL_LEVELS) - 1)
+
+// --- Timer Service State ---
+// wheel[0] holds timers due within the next WHEEL_SIZE ticks, one slot per
+// tick. Each higher level covers WHEEL_SIZE times the range of the one below
+// it, and its slots are cascaded down whenever the lower level wraps around.
+static tusk_timer_t *wheel[TIMER_WHEEL_LEVELS][WHEEL_SIZE];
+
+// The next tick the service has to process. While the service task is
+// blocked this is always rtos_ticks + 1.
+static uint32_t wheel_time;
+
+// Timers whose slot has been processed but whose callback has not run yet
+static tusk_timer_t *expired_list;
+
+static tcb_t timer_tcb;
+// Set while the service task sleeps in its own loop. Being blocked is not
+// enough: a callback may block on a mutex or queue, and then the task sits
+// on a wait queue and has not finished the ticks before it.
+static uint8_t timer_parked;
+static uint32_t timer_stack[TUSK_TIMER_STACK_SIZE];
+
+/* --- Wheel helpers (interrupts must be disabled) --- */
+
+static void timer_link(tusk_timer_t **list, tusk_timer_t *timer)
+{
+	timer->next = *list;
+	if (timer->next != NULL) {
+		timer->next->pprev = &timer->next;
+	}
+	timer->pprev = list;
+	*list = timer;
+}
+
+static void timer_unlink(tusk_timer_t *timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next != NULL) {
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = NULL;
+	timer->pprev = NULL;
+}
+
+static void wheel_insert(tusk_timer_t *timer)
+{
+	uint32_t delta = timer->expiry - wheel_time;
+	uint32_t expiry = timer->expiry;
+	uint8_t level;
+
+	if ((int32_t)delta < 0) {
+		// Already due: file it in the slot that is processed next
+		delta = 0;
+		expiry = wheel_time;
+	} else if (delta > WHEEL_MAX_DELTA) {
+		// Too far away: park it at the edge of the wheel, it will be
+		// re-filed from its real expiry when that slot cascades.
+		delta = WHEEL_MAX_DELTA;
+		expiry = wheel_time + WHEEL_MAX_DELTA;
+	}
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < WHEEL_SPAN(level + 1)) {
+			break;
+		}
+	}
+
+	timer->level = level;
+	timer_link(&wheel[level][(expiry >> (TIMER_WHEEL_BITS * level)) &
+				 WHEEL_MASK],
+		   timer);
+}
+
+/* Re-files every timer of an upper-level slot relative to wheel_time. */
+static uint32_t cascade(uint8_t level)
+{
+	uint32_t index = (wheel_time >> (TIMER_WHEEL_BITS * level)) & WHEEL_MASK;
+	tusk_timer_t *timer = wheel[level][index];
+
+	wheel[level][index] = NULL;
+	while (timer != NULL) {
+		tusk_timer_t *next = timer->next;
+		wheel_insert(timer);
+		timer = next;
+	}
+	return index;
+}
+
+/* Returns non-zero if processing tick `t` would cascade a non-empty slot. */
+static uint8_t cascade_pending(uint32_t t)
+{
+	for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+		uint32_t index = (t >> (TIMER_WHEEL_BITS * level)) & WHEEL_MASK;
+		if (wheel[level][index] != NULL) {
+			return 1;
+		}
+		if (index != 0) {
+			break;
+		}
+	}
+	return 0;
+}
+
+/* Processes tick `wheel_time`: cascades if needed and collects due timers. */
+static void wheel_advance(void)
+{
+	uint32_t index = wheel_time & WHEEL_MASK;
+
+	if (index == 0) {
+		for (uint8_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+			if (cascade(level) != 0) {
+				break;
+			}
+		}
+	}
+
+	// Every timer in this level-0 slot expires on this very tick
+	expired_list = wheel[0][index];
+	wheel[0][index] = NULL;
+	if (expired_list != NULL) {
+		expired_list->pprev = &expired_list;
+	}
+
+	wheel_time++;
+}
+
+/* --- Timer Service Task --- */
+
+static void timer_task(void)
+{
+	while (1) {
+		port_disable_interrupts();
+		if (expired_list == NULL) {
+			if ((int32_t)(rtos_ticks - wheel_time) < 0) {
+				// Caught up: sleep until the tick handler finds a due slot
+				timer_parked = 1;
+				block_current_task();
+				port_enable_interrupts();
+				trigger_context_switch();
+				continue;
+			}
+			wheel_advance();
+			port_enable_interrupts();
+			continue;
+		}
+
+		tusk_timer_t *timer = expired_list;
+		timer_unlink(timer);
+		if (timer->mode == TUSK_TIMER_AUTO_RELOAD) {
+			// Re-arm from the old expiry so the period does not drift
+			timer->expiry += timer->period;
+			wheel_insert(timer);
+		}
+		port_enable_interrupts();
+
+		timer->callback(timer, timer->arg);
+	}
+}
+
+void timer_service_init(void)
+{
+	for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (uint32_t i = 0; i < WHEEL_SIZE; i++) {
+			wheel[level][i] = NULL;
+		}
+	}
+	expired_list = NULL;
+	wheel_time = rtos_ticks;
+	timer_parked = 0;
+
+	init_tcb(&timer_tcb, timer_stack, sizeof(timer_stack), timer_task,
+		 TUSK_TIMER_TASK_PRIORITY);
+	add_to_ready_list(&timer_tcb);
+}
+
+uint8_t timer_service_tick(void)
+{
+	// A service that is not parked processes every tick up to rtos_ticks
+	// on its own, even if a callback has it blocked right now
+	if (!timer_parked) {
+		return 0;
+	}
+
+	if (wheel[0][rtos_ticks & WHEEL_MASK] == NULL &&
+	    ((rtos_ticks & WHEEL_MASK) != 0 || !cascade_pending(rtos_ticks))) {
+		// Nothing due on this tick, skip it without waking the service
+		wheel_time = rtos_ticks + 1;
+		return 0;
+	}
+
+	timer_parked = 0;
+	add_to_ready_list(&timer_tcb);
+	return timer_tcb.priority > current_tcb->priority;
+}
+
+tcb_t *timer_service_task(void)
+{
+	return &timer_tcb;
+}
+
+/* --- Public API --- */
+
+int tusk_timer_create(tusk_timer_t *timer, tusk_timer_callback_t callback,
+		      void *arg, uint32_t period, uint8_t mode)
+{
+	if (timer == NULL || callback == NULL || period == 0) {
+		return -1;
+	}
+	if (mode != TUSK_TIMER_ONE_SHOT && mode != TUSK_TIMER_AUTO_RELOAD) {
+		return -1;
+	}
+
+	timer->next = NULL;
+	timer->pprev = NULL;
+	timer->expiry = 0;
+	timer->period = period;
+	timer->mode = mode;
+	timer->level = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+	return 0;
+}
+
+int tusk_timer_start(tusk_timer_t *timer)
+{
+	if (timer == NULL || timer->callback == NULL) {
+		return -1;
+	}
+
+	port_disable_interrupts();
+	if (timer->pprev != NULL) {
+		timer_unlink(timer);
+	}
+	timer->expiry = rtos_ticks + timer->period;
+	wheel_insert(timer);
+	port_enable_interrupts();
+	return 0;
+}
+
+int tusk_timer_stop(tusk_timer_t *timer)
+{
+	if (timer == NULL) {
+		return -1;
+	}
+
+	port_disable_interrupts();
+	if (timer->pprev != NULL) {
+		timer_unlink(timer);
+	}
+	port_enable_interrupts();
+	return 0;
+}
+
+uint8_t tusk_timer_is_active(const tusk_timer_t *timer)
+{
+	return (timer != NULL && timer->pprev != NULL) ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#include "../include/trace.h"
+#include "../include/kernel.h"
+#include "../include/serial.h"
+
+#if TUSK_USE_TRACE
+
+#if (TUSK_TRACE_BUFFER_SIZE & (TUSK_TRACE_BUFFER_SIZE - 1)) != 0
+#error "TUSK_TRACE_BUFFER_SIZE must be a power of two"
+#endif
+
+#define TRACE_MASK (TUSK_TRACE_BUFFER_SIZE - 1)
+
+// Keeps the compiler from publishing a slot before its contents are written
+#define barrier() __asm__ volatile("" : : : "memory")
+
+typedef struct {
+	uint32_t timestamp;
+	// Claim number + 1 of the event in this slot, written last. The drain
+	// only trusts a slot whose sequence matches the event it expects.
+	volatile uint32_t sequence;
+	uint8_t event;
+	uint8_t task;
+	uint16_t arg;
+} trace_slot_t;
+
+static trace_slot_t trace_buffer[TUSK_TRACE_BUFFER_SIZE];
+
+// Number of events claimed so far. Writers bump it atomically.
+static volatile uint32_t trace_head = 0;
+
+// Number of events drained so far. Only touched by tusk_trace_drain().
+static uint32_t trace_tail = 0;
+
+static uint8_t header_sent = 0;
+
+void trace_record(uint8_t event, const tcb_t *task, uint16_t arg)
+{
+	uint32_t index = port_atomic_add(&trace_head, 1);
+	trace_slot_t *slot = &trace_buffer[index & TRACE_MASK];
+
+	slot->timestamp = port_get_cycles();
+	slot->event = event;
+	slot->task = trace_task_index(task);
+	slot->arg = arg;
+	barrier();
+	slot->sequence = index + 1;
+}
+
+/* Writes `value` as `digits` hex digits and returns the position after them. */
+static char *put_hex(char *out, uint32_t value, int digits)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	for (int i = digits - 1; i >= 0; i--) {
+		out[i] = hex[value & 0xF];
+		value >>= 4;
+	}
+	return out + digits;
+}
+
+static void print_record(char tag, uint32_t value)
+{
+	char line[16];
+	char *out = line;
+
+	*out++ = '@';
+	*out++ = tag;
+	out = put_hex(out, value, 8);
+	*out++ = '\r';
+	*out++ = '\n';
+	*out = '\0';
+	serial_print(line);
+}
+
+uint32_t tusk_trace_drain(void)
+{
+	uint32_t sent = 0;
+	uint32_t lost = 0;
+	char line[24];
+
+	if (!header_sent) {
+		print_record('H', PORT_CYCLES_HZ);
+		header_sent = 1;
+	}
+
+	while (trace_tail != trace_head) {
+		// Writers lapped us: skip what has been overwritten
+		if (trace_head - trace_tail > TUSK_TRACE_BUFFER_SIZE) {
+			uint32_t oldest = trace_head - TUSK_TRACE_BUFFER_SIZE;
+			lost += oldest - trace_tail;
+			trace_tail = oldest;
+			continue;
+		}
+
+		trace_slot_t *slot = &trace_buffer[trace_tail & TRACE_MASK];
+		uint32_t expected = trace_tail + 1;
+		if (slot->sequence != expected) {
+			if ((int32_t)(slot->sequence - expected) > 0) {
+				// Overwritten by a newer event
+				lost++;
+				trace_tail++;
+				continue;
+			}
+			break; // Claimed but not written yet, try again next time
+		}
+
+		uint32_t timestamp = slot->timestamp;
+		uint8_t event = slot->event;
+		uint8_t task = slot->task;
+		uint16_t arg = slot->arg;
+		barrier();
+		trace_tail++;
+		if (slot->sequence != expected) {
+			lost++; // Overwritten while we were copying it
+			continue;
+		}
+
+		char *out = line;
+		*out++ = '@';
+		*out++ = 'T';
+		out = put_hex(out, timestamp, 8);
+		out = put_hex(out, event, 2);
+		out = put_hex(out, task, 2);
+		out = put_hex(out, arg, 4);
+		*out++ = '\r';
+		*out++ = '\n';
+		*out = '\0';
+		serial_print(line);
+		sent++;
+	}
+
+	if (lost != 0) {
+		print_record('L', lost);
+	}
+	return sent;
+}
+
+#endif // TUSK_USE_TRACE
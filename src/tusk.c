@@ -1,116 +1,804 @@
 #include "../include/tusk.h"
 #include "../include/sync.h"
+#include "../include/kernel.h"
 #include <stddef.h> // For NULL
 
 // --- Kernel Globals ---
 tcb_t tasks[MAX_TASKS];
-uint32_t task_stacks[MAX_TASKS][STACK_SIZE];
 tcb_t *current_tcb = NULL;
 uint32_t task_count = 0;
 volatile uint32_t rtos_ticks = 0;
 
-// --- Private Function Prototypes ---
-void rtos_scheduler(void);
-void add_to_wait_list(struct tcb **list, tcb_t *task);
-tcb_t *remove_from_wait_list(struct tcb **list);
+// --- Ready Queues ---
+// One circular list per priority, plus a bitmap with bit N set whenever
+// ready_list[N] is non-empty. The idle task keeps the bitmap from ever
+// being zero, so the scheduler never has to handle "nothing to run".
+tcb_t *ready_list[TUSK_MAX_PRIORITIES];
+uint32_t ready_bitmap = 0;
+
+// --- Delay List ---
+// Sleeping tasks sorted by wakeup_time, earliest first, so the tick handler
+// only ever has to look at the head.
+tcb_t *delay_list = NULL;
+
+// --- Notification States ---
+#define NOTIFY_NONE 0
+#define NOTIFY_PENDING 1 // Sent but not yet consumed by tusk_notify_wait()
+#define NOTIFY_WAITING 2 // The task is blocked in tusk_notify_wait()
+
+// Ticks left in the running task's time slice
+static uint32_t time_slice_remaining = TUSK_TIME_SLICE_TICKS;
+
+// Set by tusk_start(). Until then there is no running task to preempt.
+static uint8_t scheduler_started = 0;
+
+#if TUSK_USE_STATS
+// port_get_cycles() at the last time run time was charged to a task
+static uint32_t stats_timestamp = 0;
+
+// Time elapsed since tusk_start(), in port_get_cycles() units
+static uint64_t stats_total_time = 0;
+#endif
+
+#if TUSK_USE_EDF
+// Sum of wcet / deadline over all admitted EDF tasks
+static uint32_t edf_utilization = 0;
+#endif
+
+// --- Task Pool ---
+// Unused TCBs are chained through wait_next. Tasks that deleted themselves
+// wait on the zombie list until their stack is no longer in use.
+static tcb_t *free_tcb_list = NULL;
+static tcb_t *zombie_list = NULL;
+
+// --- Stack Arena ---
+// Task stacks are carved out of the arena on creation and handed back on
+// deletion. Free chunks are kept in address order so that neighbours can be
+// merged again, which keeps the arena from fragmenting as tasks come and go.
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size; // In bytes, including this header
+} arena_chunk_t;
+
+#define ARENA_GRANULE sizeof(arena_chunk_t)
+
+static uint64_t stack_arena[TUSK_STACK_ARENA_SIZE / sizeof(uint64_t)];
+static arena_chunk_t *arena_free_list = NULL;
+
+static tcb_t idle_tcb;
+static uint32_t idle_stack[IDLE_STACK_SIZE];
+
+static void update_inherited_priority(tcb_t *task);
+static void drop_held_mutex(tcb_t *task, tusk_mutex_t *mutex);
+static tcb_t *pass_mutex_on(tusk_mutex_t *mutex);
 
 /*
- * SVC_Handler and PendSV_Handler are defined in rtos_asm.s
- * These are the entry points for starting the first task and context switching.
+ * Context switching is done by the port (see port.h). It calls
+ * rtos_scheduler() to pick the next task and SysTick_Handler() on every tick.
  */
-extern void SVC_Handler(void);
-extern void PendSV_Handler(void);
-extern void tusk_start(void); // Assembly function to trigger SVC
+
+#if TUSK_USE_EDF
+static inline uint8_t deadline_before(const tcb_t *a, const tcb_t *b)
+{
+	return (int32_t)(a->absolute_deadline - b->absolute_deadline) < 0;
+}
+#endif
+
+/* Returns non-zero if a task that just became ready should preempt the running one. */
+static uint8_t should_preempt(const tcb_t *task)
+{
+#if TUSK_USE_EDF
+	if (task->priority == TUSK_EDF_PRIORITY &&
+	    current_tcb->priority == TUSK_EDF_PRIORITY) {
+		return deadline_before(task, current_tcb);
+	}
+#endif
+	return task->priority > current_tcb->priority;
+}
+
+#if TUSK_USE_STATS
+/* Charges the time since the last update to the running task. Interrupts must be disabled. */
+static void update_run_time(void)
+{
+	uint32_t now = port_get_cycles();
+	uint32_t elapsed = now - stats_timestamp;
+
+	stats_timestamp = now;
+	current_tcb->run_time += elapsed;
+	stats_total_time += elapsed;
+}
+#endif
+
+void wake_task(tcb_t *task)
+{
+	// A timed waiter must not be woken a second time by its timeout
+	if (task->delay_prev != NULL || delay_list == task) {
+		remove_from_delay_list(task);
+	}
+	add_to_ready_list(task);
+	if (should_preempt(task)) {
+		trigger_context_switch();
+	}
+}
+
+void block_current_task(void)
+{
+	remove_from_ready_list(current_tcb);
+	current_tcb->state = TASK_BLOCKED;
+}
+
+void block_current_task_timeout(uint32_t timeout)
+{
+	block_current_task();
+	current_tcb->timed_out = 0;
+	if (timeout != TUSK_WAIT_FOREVER) {
+		add_to_delay_list(current_tcb, rtos_ticks + timeout);
+	}
+}
+
+/* Takes a blocked task off its wait queue, and returns any priority it lent
+ * to a mutex owner. Interrupts must be disabled. */
+static void cancel_wait(tcb_t *task)
+{
+	if (task->wait_list != NULL) {
+		unlink_from_wait_list(task);
+	}
+	if (task->blocked_on != NULL) {
+		// The owner no longer has to run at our priority
+		tusk_mutex_t *mutex = task->blocked_on;
+		task->blocked_on = NULL;
+		update_inherited_priority(tusk_mutex_owner(mutex));
+	}
+}
+
+/* --- Stack arena helpers (interrupts must be disabled) --- */
+
+static void *arena_alloc(size_t size)
+{
+	arena_chunk_t **link = &arena_free_list;
+
+	if (size == 0) {
+		return NULL; // A zero-sized split would hand out a listed chunk
+	}
+
+	// First fit. Sizes are multiples of the chunk header, so any remainder
+	// is either zero or large enough to stay on the free list.
+	while (*link != NULL) {
+		arena_chunk_t *chunk = *link;
+		if (chunk->size >= size) {
+			if (chunk->size > size) {
+				arena_chunk_t *rest =
+					(arena_chunk_t *)((uint8_t *)chunk + size);
+				rest->next = chunk->next;
+				rest->size = chunk->size - size;
+				*link = rest;
+			} else {
+				*link = chunk->next;
+			}
+			return chunk;
+		}
+		link = &chunk->next;
+	}
+	return NULL;
+}
+
+static void arena_free(void *block, size_t size)
+{
+	arena_chunk_t *chunk = (arena_chunk_t *)block;
+	arena_chunk_t *prev = NULL;
+	arena_chunk_t *next = arena_free_list;
+
+	while (next != NULL && next < chunk) {
+		prev = next;
+		next = next->next;
+	}
+
+	chunk->size = size;
+	chunk->next = next;
+
+	// Merge with the following chunk
+	if (next != NULL && (uint8_t *)chunk + chunk->size == (uint8_t *)next) {
+		chunk->size += next->size;
+		chunk->next = next->next;
+	}
+
+	// Merge with the preceding chunk
+	if (prev != NULL && (uint8_t *)prev + prev->size == (uint8_t *)chunk) {
+		prev->size += chunk->size;
+		prev->next = chunk->next;
+	} else if (prev != NULL) {
+		prev->next = chunk;
+	} else {
+		arena_free_list = chunk;
+	}
+}
+
+/* Returns a deleted task's stack and TCB. Interrupts must be disabled. */
+static void release_task(tcb_t *task)
+{
+	port_release_task(task);
+	if (task->owns_stack) {
+		arena_free(task->stack_base, task->stack_size);
+	}
+	task->state = TASK_INACTIVE;
+	task->stack_pointer = NULL;
+	task->wait_next = free_tcb_list;
+	free_tcb_list = task;
+}
+
+/* Frees every task that deleted itself. Interrupts must be disabled. */
+static void reclaim_deleted_tasks(void)
+{
+	while (zombie_list != NULL) {
+		tcb_t *task = zombie_list;
+		zombie_list = task->wait_next;
+		release_task(task);
+	}
+}
+
+static void idle_task(void)
+{
+	while (1) {
+		// Stacks of self-deleted tasks can only be freed once they are
+		// switched out, so the idle task picks them up.
+		if (zombie_list != NULL) {
+			port_disable_interrupts();
+			reclaim_deleted_tasks();
+			port_enable_interrupts();
+		}
+		port_idle();
+	}
+}
+
+/* Tasks whose handler returns end up here. */
+static void task_exit(void)
+{
+	tusk_delete_task(NULL);
+}
 
 /* SysTick_Handler - The heart of the preemptive scheduler */
 void SysTick_Handler(void)
 {
+	uint8_t switch_needed = 0;
+
+	// The tick runs at the lowest priority, so interrupts that call the
+	// *_from_isr functions could otherwise preempt it mid-update
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+
+#if TUSK_USE_STATS
+	// Keeps the 32-bit timestamp deltas short even if nobody switches
+	update_run_time();
+#endif
 	rtos_ticks++;
 
-	// Check for any sleeping tasks that need to wake up
-	for (uint32_t i = 0; i < task_count; i++) {
-		if (tasks[i].state == TASK_BLOCKED &&
-		    tasks[i].wakeup_time > 0 &&
-		    rtos_ticks >= tasks[i].wakeup_time) {
-			tasks[i].state = TASK_READY;
-			tasks[i].wakeup_time = 0;
+	// Wake every task whose delay has expired. The list is sorted, so we
+	// stop at the first task that still has to sleep.
+	while (delay_list != NULL &&
+	       (int32_t)(rtos_ticks - delay_list->wakeup_time) >= 0) {
+		tcb_t *task = delay_list;
+		remove_from_delay_list(task);
+		if (task->wait_list != NULL) {
+			// A timed wait expired. Leaving a mutex queue may lower
+			// the owner's priority, so always let the scheduler look.
+			cancel_wait(task);
+			TRACE_EVENT(TRACE_WAIT_TIMEOUT, task, 0);
+			switch_needed = 1;
 		}
+		task->timed_out = 1;
+		add_to_ready_list(task);
+		TRACE_EVENT(TRACE_DELAY_EXPIRE, task, 0);
+		if (should_preempt(task)) {
+			switch_needed = 1;
+		}
+	}
+
+	// Let the timer service run if a timer is due on this tick
+	if (timer_service_tick()) {
+		switch_needed = 1;
 	}
 
-	// Trigger PendSV to run the scheduler and perform a context switch
-	// SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk;
-	// Using a direct address for compatibility
-	*(volatile uint32_t *)0xE000ED04 |= (1 << 28);
+	// Rotate among tasks of equal priority once the time slice is used up.
+	// The EDF level stays sorted by deadline and is never rotated.
+	if (--time_slice_remaining == 0) {
+		time_slice_remaining = TUSK_TIME_SLICE_TICKS;
+		if (current_tcb->state == TASK_READY &&
+#if TUSK_USE_EDF
+		    current_tcb->priority != TUSK_EDF_PRIORITY &&
+#endif
+		    current_tcb->next_tcb != current_tcb) {
+			ready_list[current_tcb->priority] = current_tcb->next_tcb;
+			TRACE_EVENT(TRACE_TIME_SLICE, current_tcb, 0);
+			switch_needed = 1;
+		}
+	}
+
+	// Only pay for a context switch if someone else should run now
+	if (switch_needed) {
+		trigger_context_switch();
+	}
+	port_clear_interrupt_mask_from_isr(mask);
+}
+
+void init_tcb(tcb_t *tcb, uint32_t *stack, size_t stack_size,
+	      void (*task_handler)(void), uint8_t priority)
+{
+	tcb->stack_base = stack;
+	tcb->stack_size = stack_size;
+	tcb->owns_stack = 0;
+#if TUSK_USE_STATS
+	// Paint the stack so its high-water mark can be measured later
+	for (size_t i = 0; i < stack_size / sizeof(uint32_t); i++) {
+		stack[i] = TUSK_STACK_FILL;
+	}
+	tcb->run_time = 0;
+	tcb->switch_count = 0;
+#endif
+	tcb->stack_pointer = port_init_stack(
+		(uint32_t *)((uint8_t *)stack + stack_size), task_handler,
+		task_exit);
+	tcb->priority = priority;
+	tcb->base_priority = priority;
+	tcb->held_mutexes = NULL;
+	tcb->pending_mutex = NULL;
+	tcb->blocked_on = NULL;
+	tcb->wakeup_time = 0;
+	tcb->delay_next = NULL;
+	tcb->delay_prev = NULL;
+	tcb->wait_next = NULL;
+	tcb->wait_prev = NULL;
+	tcb->wait_list = NULL;
+	tcb->timed_out = 0;
+	tcb->wait_message = NULL;
+	tcb->event_bits = 0;
+	tcb->event_options = 0;
+	tcb->notify_value = 0;
+	tcb->notify_state = NOTIFY_NONE;
+	tcb->pool_caches = NULL;
+#if TUSK_USE_EDF
+	tcb->period = 0;
+	tcb->deadline_misses = 0;
+#endif
 }
 
 void tusk_init(void)
 {
-	// Reset all tasks
-	for (int i = 0; i < MAX_TASKS; i++) {
-		tasks[i].state = 0; // Inactive
+	// Reset all tasks and chain them into the pool of free TCBs
+	free_tcb_list = NULL;
+	zombie_list = NULL;
+	for (int i = MAX_TASKS - 1; i >= 0; i--) {
+		tasks[i].state = TASK_INACTIVE;
 		tasks[i].stack_pointer = NULL;
+		tasks[i].wait_next = free_tcb_list;
+		free_tcb_list = &tasks[i];
+	}
+	task_count = 0;
+
+	// The whole arena starts out as one free chunk
+	arena_free_list = (arena_chunk_t *)stack_arena;
+	arena_free_list->next = NULL;
+	arena_free_list->size = sizeof(stack_arena);
+	for (int i = 0; i < TUSK_MAX_PRIORITIES; i++) {
+		ready_list[i] = NULL;
 	}
-	current_tcb = &tasks[0]; // Start with the first task
+	ready_bitmap = 0;
+	delay_list = NULL;
 
-	// Configure SysTick for a 1ms tick (assuming a 16MHz clock for simplicity)
-	// You MUST adjust this value for your actual system clock frequency.
-	// Example: For 16MHz clock, to get 1000Hz (1ms tick): 16,000,000 / 1000 = 16,000
-	// SysTick->LOAD = 16000 - 1;
-	// SysTick->VAL = 0;
-	// SysTick->CTRL = 0x07; // Enable, Use Processor Clock, Enable Interrupt
+	// The idle task occupies the lowest priority and is always ready
+	init_tcb(&idle_tcb, idle_stack, sizeof(idle_stack), idle_task,
+		 TUSK_IDLE_PRIORITY);
+	add_to_ready_list(&idle_tcb);
+
+	// Software timers run in their own kernel task
+	timer_service_init();
+
+	// tusk_start() lets the scheduler pick the first real task
+	current_tcb = &idle_tcb;
 }
 
-int tusk_create_task(void (*task_handler)(void))
+#if TUSK_USE_EDF
+/* The share of the CPU an EDF task may claim, rounded up to stay on the safe side. */
+static uint32_t edf_density(uint32_t wcet, uint32_t deadline)
 {
-	if (task_count >= MAX_TASKS) {
-		return -1; // Error: Max tasks reached
-	}
+	return (wcet * TUSK_EDF_UTILIZATION_SCALE + deadline - 1) / deadline;
+}
+#endif
 
-	tcb_t *new_tcb = &tasks[task_count];
-	uint32_t *stack_top = &task_stacks[task_count][STACK_SIZE - 1];
+/*
+ * Takes a TCB (and an arena stack unless one is given) and prepares it. The
+ * task is not made ready. Only the bookkeeping is done with interrupts
+ * disabled: the new TCB stays TASK_INACTIVE and invisible to the scheduler
+ * until it is added to a ready list, so filling it in (and painting a
+ * possibly large stack) can run with interrupts enabled.
+ */
+static tcb_t *create_task(void (*task_handler)(void), uint8_t priority,
+			  uint32_t *stack, size_t stack_size)
+{
+	uint8_t owns_stack = 0;
 
-	// Initialize the task stack for Cortex-M
-	*(--stack_top) = 0x01000000; // xPSR (Thumb state)
-	*(--stack_top) = (uint32_t)task_handler; // PC (program counter)
-	*(--stack_top) = 0; // LR (link register)
-	*(--stack_top) = 0; // R12
-	*(--stack_top) = 0; // R3
-	*(--stack_top) = 0; // R2
-	*(--stack_top) = 0; // R1
-	*(--stack_top) = 0; // R0
-	// The processor automatically saves R4-R11
-	*(--stack_top) = 0; // R11
-	*(--stack_top) = 0; // R10
-	*(--stack_top) = 0; // R9
-	*(--stack_top) = 0; // R8
-	*(--stack_top) = 0; // R7
-	*(--stack_top) = 0; // R6
-	*(--stack_top) = 0; // R5
-	*(--stack_top) = 0; // R4
+	port_disable_interrupts();
+	// Make room from tasks that deleted themselves before giving up
+	if (free_tcb_list == NULL || stack == NULL) {
+		reclaim_deleted_tasks();
+	}
+
+	if (free_tcb_list == NULL) {
+		port_enable_interrupts();
+		return NULL; // Error: Max tasks reached
+	}
 
-	new_tcb->stack_pointer = stack_top;
-	new_tcb->state = TASK_READY;
-	new_tcb->next_tcb = &tasks[(task_count + 1) % task_count];
-	if (task_count > 0) {
-		tasks[task_count - 1].next_tcb = new_tcb;
+	if (stack == NULL) {
+		stack = arena_alloc(stack_size);
+		if (stack == NULL) {
+			port_enable_interrupts();
+			return NULL; // Error: Stack arena exhausted
+		}
+		owns_stack = 1;
 	}
 
+	tcb_t *new_tcb = free_tcb_list;
+	free_tcb_list = new_tcb->wait_next;
 	task_count++;
-	return 0; // Success
+	port_enable_interrupts();
+
+	init_tcb(new_tcb, stack, stack_size, task_handler, priority);
+	new_tcb->owns_stack = owns_stack;
+	return new_tcb;
+}
+
+/* Returns 0 for sizes the arena can never hold, which arena_alloc() rejects. */
+static size_t round_stack_size(size_t stack_size)
+{
+	if (stack_size == 0) {
+		stack_size = STACK_SIZE;
+	} else if (stack_size < TUSK_MIN_STACK_SIZE) {
+		stack_size = TUSK_MIN_STACK_SIZE;
+	} else if (stack_size > TUSK_STACK_ARENA_SIZE) {
+		return 0; // Rounding up could wrap around
+	}
+	return (stack_size + ARENA_GRANULE - 1) & ~(ARENA_GRANULE - 1);
+}
+
+static tcb_t *spawn_task(void (*task_handler)(void), uint8_t priority,
+			 uint32_t *stack, size_t stack_size)
+{
+	if (task_handler == NULL || priority >= TUSK_MAX_PRIORITIES) {
+		return NULL; // Error: Invalid handler or priority
+	}
+#if TUSK_USE_EDF
+	if (priority == TUSK_EDF_PRIORITY) {
+		return NULL; // Error: Reserved for EDF tasks
+	}
+#endif
+
+	tcb_t *new_tcb = create_task(task_handler, priority, stack, stack_size);
+	if (new_tcb == NULL) {
+		return NULL;
+	}
+
+	port_disable_interrupts();
+	add_to_ready_list(new_tcb);
+	TRACE_EVENT(TRACE_TASK_CREATE, new_tcb, priority);
+	// A more urgent task starts running right away
+	if (scheduler_started && should_preempt(new_tcb)) {
+		trigger_context_switch();
+	}
+	port_enable_interrupts();
+
+	return new_tcb;
+}
+
+tcb_t *tusk_create_task(void (*task_handler)(void), uint8_t priority,
+			size_t stack_size)
+{
+	return spawn_task(task_handler, priority, NULL,
+			  round_stack_size(stack_size));
+}
+
+tcb_t *tusk_create_task_static(void (*task_handler)(void), uint8_t priority,
+			       uint32_t *stack, size_t stack_size)
+{
+	if (stack == NULL || stack_size < TUSK_MIN_STACK_SIZE) {
+		return NULL;
+	}
+	// Only whole 8-byte units of the buffer are used, so the stack
+	// statistics never look past its end
+	return spawn_task(task_handler, priority, stack,
+			  stack_size & ~(size_t)7);
+}
+
+int tusk_delete_task(tcb_t *task)
+{
+	if (task == NULL) {
+		task = current_tcb;
+	}
+	if (task < &tasks[0] || task >= &tasks[MAX_TASKS]) {
+		return -1; // Error: Kernel tasks cannot be deleted
+	}
+	if (task == current_tcb && task->pool_caches != NULL) {
+		// May take pool mutexes, so it comes before the critical section
+		mem_pool_cache_flush_task(task);
+	}
+
+	port_disable_interrupts();
+	if (task->state == TASK_INACTIVE || task->state == TASK_DELETED) {
+		port_enable_interrupts();
+		return -1; // Error: Not a live task
+	}
+
+	// Another task may have been preempted halfway through a cache
+	// operation. That cache is cut loose, blocks and all; the others are
+	// flushed below.
+	mem_pool_cache_detach_busy(task);
+
+	TRACE_EVENT(TRACE_TASK_DELETE, task, 0);
+
+	// Detach the task from every list it may be queued on
+	if (task->state == TASK_READY) {
+		remove_from_ready_list(task);
+	}
+	if (task->delay_prev != NULL || delay_list == task) {
+		remove_from_delay_list(task);
+	}
+	cancel_wait(task);
+
+	// Pass on every mutex the task still holds. Otherwise its waiters
+	// would block forever and keep lending their priority to a dead TCB.
+	while (task->held_mutexes != NULL) {
+		tusk_mutex_t *mutex = task->held_mutexes;
+		drop_held_mutex(task, mutex);
+		mutex->depth = 0;
+		tcb_t *waiter = pass_mutex_on(mutex);
+		if (waiter != NULL) {
+			wake_task(waiter);
+		}
+	}
+	// The task may have been stopped on a fast path while the mutex was
+	// locked to it but off its list
+	tusk_mutex_t *pending = task->pending_mutex;
+	if (pending != NULL && tusk_mutex_owner(pending) == task) {
+		pending->next_held = NULL;
+		pending->depth = 0;
+		tcb_t *waiter = pass_mutex_on(pending);
+		if (waiter != NULL) {
+			wake_task(waiter);
+		}
+	}
+	task->pending_mutex = NULL;
+#if TUSK_USE_EDF
+	if (task->period != 0) {
+		edf_utilization -= edf_density(task->wcet, task->relative_deadline);
+	}
+#endif
+	task_count--;
+
+	if (task == current_tcb) {
+		// We are still running on this stack; the idle task frees it
+		// once we have been switched out for good.
+		task->state = TASK_DELETED;
+		task->wait_next = zombie_list;
+		zombie_list = task;
+		port_enable_interrupts();
+		trigger_context_switch();
+		while (1) {
+		}
+	}
+
+	if (task->pool_caches != NULL) {
+		// The task is off every list and never runs again, so its caches
+		// can be flushed with interrupts enabled, as pool mutexes need.
+		// Keep the stack, which may hold them, until then.
+		task->state = TASK_DELETED;
+		port_enable_interrupts();
+		mem_pool_cache_flush_task(task);
+		port_disable_interrupts();
+	}
+	release_task(task);
+	port_enable_interrupts();
+	return 0;
+}
+
+tcb_t *tusk_current_task(void)
+{
+	return current_tcb;
+}
+
+#if TUSK_USE_EDF
+tcb_t *tusk_create_periodic_task(void (*task_handler)(void), uint32_t period,
+				 uint32_t deadline, uint32_t wcet,
+				 size_t stack_size)
+{
+	if (task_handler == NULL || wcet == 0 || wcet > deadline ||
+	    deadline > period || wcet > UINT32_MAX / TUSK_EDF_UTILIZATION_SCALE) {
+		return NULL; // Error: Invalid timing parameters
+	}
+
+	// Density test: sum(wcet / deadline) <= limit
+	uint32_t density = edf_density(wcet, deadline);
+
+	port_disable_interrupts();
+	if (edf_utilization + density > TUSK_EDF_UTILIZATION_LIMIT) {
+		port_enable_interrupts();
+		return NULL; // Error: Admission test failed
+	}
+	// Reserve the share now, so that concurrent admissions see it
+	edf_utilization += density;
+	port_enable_interrupts();
+
+	tcb_t *new_tcb = create_task(task_handler, TUSK_EDF_PRIORITY, NULL,
+				     round_stack_size(stack_size));
+	if (new_tcb == NULL) {
+		port_disable_interrupts();
+		edf_utilization -= density;
+		port_enable_interrupts();
+		return NULL;
+	}
+	new_tcb->period = period;
+	new_tcb->relative_deadline = deadline;
+	new_tcb->wcet = wcet;
+
+	port_disable_interrupts();
+	new_tcb->release_time = rtos_ticks;
+	new_tcb->absolute_deadline = rtos_ticks + deadline;
+	add_to_ready_list(new_tcb);
+	TRACE_EVENT(TRACE_TASK_CREATE, new_tcb, TUSK_EDF_PRIORITY);
+	if (scheduler_started && should_preempt(new_tcb)) {
+		trigger_context_switch();
+	}
+	port_enable_interrupts();
+
+	return new_tcb;
+}
+
+void tusk_wait_next_period(void)
+{
+	port_disable_interrupts();
+	tcb_t *task = current_tcb;
+
+	if ((int32_t)(rtos_ticks - task->absolute_deadline) > 0) {
+		task->deadline_misses++;
+	}
+
+	task->release_time += task->period;
+	task->absolute_deadline = task->release_time + task->relative_deadline;
+
+	if ((int32_t)(rtos_ticks - task->release_time) < 0) {
+		// Sleep until the next job is released
+		block_current_task();
+		add_to_delay_list(task, task->release_time);
+		port_enable_interrupts();
+		trigger_context_switch();
+		return;
+	}
+
+	// Running late: the next job is already released. Re-sort it under its
+	// new deadline and yield if another job is now more urgent.
+	remove_from_ready_list(task);
+	add_to_ready_list(task);
+	if (ready_list[TUSK_EDF_PRIORITY] != task) {
+		trigger_context_switch();
+	}
+	port_enable_interrupts();
+}
+
+uint32_t tusk_get_deadline_misses(tcb_t *task)
+{
+	if (task == NULL) {
+		task = current_tcb;
+	}
+	return task->deadline_misses;
+}
+#endif
+
+void tusk_start(void)
+{
+#if TUSK_USE_STATS
+	stats_timestamp = port_get_cycles();
+	stats_total_time = 0;
+#endif
+
+	// Let the scheduler pick the highest-priority task to run first
+	rtos_scheduler();
+	scheduler_started = 1;
+
+	// The port starts the tick and switches to it. This does not return.
+	port_start_first_task();
+}
+
+#if TUSK_USE_STATS
+/* Returns how many bytes at the top of the stack no longer hold the paint pattern. */
+static uint32_t stack_high_water(const tcb_t *task)
+{
+	const uint32_t *word = task->stack_base;
+	const uint32_t *end =
+		(const uint32_t *)((const uint8_t *)task->stack_base +
+				   task->stack_size);
+
+	// Stacks grow down, so the lowest overwritten word marks the peak
+	while (word < end && *word == TUSK_STACK_FILL) {
+		word++;
+	}
+	return (uint32_t)((const uint8_t *)end - (const uint8_t *)word);
+}
+
+static void fill_task_stats(tusk_task_stats_t *entry, tcb_t *task)
+{
+	entry->task = task;
+	entry->priority = task->priority;
+	entry->state = task->state;
+	entry->run_time = task->run_time;
+	entry->switch_count = task->switch_count;
+	entry->stack_size = task->stack_size;
+}
+
+uint32_t tusk_get_task_stats(tusk_task_stats_t *stats, uint32_t max_entries,
+			     uint64_t *total_run_time)
+{
+	uint32_t count = 0;
+
+	if (stats == NULL) {
+		return 0;
+	}
+
+	// Copy the counters atomically, including the running task's
+	// current time slice
+	port_disable_interrupts();
+	if (scheduler_started) {
+		update_run_time();
+	}
+	if (count < max_entries) {
+		fill_task_stats(&stats[count++], &idle_tcb);
+	}
+	if (count < max_entries) {
+		fill_task_stats(&stats[count++], timer_service_task());
+	}
+	for (int i = 0; i < MAX_TASKS && count < max_entries; i++) {
+		if (tasks[i].state != TASK_INACTIVE &&
+		    tasks[i].state != TASK_DELETED) {
+			fill_task_stats(&stats[count++], &tasks[i]);
+		}
+	}
+	if (total_run_time != NULL) {
+		*total_run_time = stats_total_time;
+	}
+	port_enable_interrupts();
+
+	// Scanning the stacks takes a while, so do it with interrupts enabled
+	for (uint32_t i = 0; i < count; i++) {
+		stats[i].stack_high_water = stack_high_water(stats[i].task);
+	}
+	return count;
+}
+#endif
+
+#if TUSK_USE_TRACE
+uint8_t trace_task_index(const tcb_t *task)
+{
+	if (task >= &tasks[0] && task < &tasks[MAX_TASKS]) {
+		return (uint8_t)(task - tasks);
+	}
+	return task == &idle_tcb ? TRACE_TASK_IDLE : TRACE_TASK_KERNEL;
 }
+#endif
 
-/* Scheduler Logic (Simple Round-Robin) */
+/* Scheduler Logic (Fixed-Priority, Round-Robin within a priority) */
 void rtos_scheduler(void)
 {
-	tcb_t *next_task = current_tcb;
-	do {
-		next_task = next_task->next_tcb;
-	} while (next_task->state != TASK_READY && next_task != current_tcb);
+	// The highest set bit in the bitmap is the highest ready priority.
+	// Time-slice rotation happens in SysTick_Handler, so the head of that
+	// queue is always the task that should run next.
+	uint32_t top_priority = 31 - port_clz(ready_bitmap);
+	tcb_t *next_task = ready_list[top_priority];
 
-	if (next_task->state == TASK_READY) {
-		current_tcb = next_task;
+	if (next_task != current_tcb) {
+		time_slice_remaining = TUSK_TIME_SLICE_TICKS;
+#if TUSK_USE_STATS
+		update_run_time();
+		next_task->switch_count++;
+#endif
+		TRACE_EVENT(TRACE_TASK_SWITCH, next_task,
+			    trace_task_index(current_tcb));
 	}
-	// If no other task is ready, we just continue with the current one.
+	current_tcb = next_task;
 }
 
 /* --- Synchronization Primitives --- */
@@ -119,116 +807,723 @@ void tusk_delay(uint32_t ticks)
 {
 	if (ticks == 0)
 		return;
-	current_tcb->wakeup_time = rtos_ticks + ticks;
-	current_tcb->state = TASK_BLOCKED;
+	port_disable_interrupts();
+	TRACE_EVENT(TRACE_TASK_DELAY, current_tcb, ticks);
+	block_current_task();
+	add_to_delay_list(current_tcb, rtos_ticks + ticks);
+	port_enable_interrupts();
 	// Trigger scheduler to switch to another task
-	*(volatile uint32_t *)0xE000ED04 |= (1 << 28); // Set PendSV
+	trigger_context_switch();
+}
+
+/* --- Priority inheritance (interrupts must be disabled) --- */
+
+/* The priority a task needs while it holds its mutexes: the highest of its
+ * base priority, the ceilings and the most urgent waiter of each mutex. */
+static uint8_t inherited_priority(const tcb_t *task)
+{
+	uint8_t priority = task->base_priority;
+
+	for (tusk_mutex_t *mutex = task->held_mutexes; mutex != NULL;
+	     mutex = mutex->next_held) {
+		if (mutex->protocol == TUSK_MUTEX_CEILING &&
+		    mutex->ceiling > priority) {
+			priority = mutex->ceiling;
+		}
+		// Wait lists are sorted, so the head is the most urgent waiter
+		if (mutex->waiting_list.head != NULL &&
+		    mutex->waiting_list.head->priority > priority) {
+			priority = mutex->waiting_list.head->priority;
+		}
+	}
+#if TUSK_USE_EDF
+	// Only EDF tasks may live on the EDF level, where the ready queue is
+	// sorted by deadline. Stopping just below it still beats every other
+	// fixed-priority task that could preempt the owner.
+	if (priority >= TUSK_EDF_PRIORITY && task->period == 0) {
+		priority = TUSK_EDF_PRIORITY - 1;
+		if (task->base_priority > priority) {
+			priority = task->base_priority;
+		}
+	}
+#endif
+	return priority;
+}
+
+static void set_task_priority(tcb_t *task, uint8_t priority)
+{
+	if (task->state == TASK_READY) {
+		remove_from_ready_list(task);
+		task->priority = priority;
+		add_to_ready_list(task);
+	} else if (task->wait_list != NULL) {
+		// Keep the wait list sorted under the new priority
+		wait_queue_t *queue = task->wait_list;
+		unlink_from_wait_list(task);
+		task->priority = priority;
+		add_to_wait_list(queue, task);
+	} else {
+		task->priority = priority;
+	}
+	TRACE_EVENT(TRACE_PRIORITY_CHANGE, task, priority);
+}
+
+static void update_inherited_priority(tcb_t *task)
+{
+	// Each step moves to the owner of the mutex the task waits for. The
+	// bound only matters for deadlocked chains, which would loop forever.
+	for (int depth = 0; task != NULL && depth <= MAX_TASKS; depth++) {
+#if TUSK_USE_EDF
+		if (task->period != 0) {
+			return; // EDF tasks are ordered by deadline only
+		}
+#endif
+		uint8_t priority = inherited_priority(task);
+		if (priority == task->priority) {
+			return;
+		}
+		set_task_priority(task, priority);
+		if (task->blocked_on == NULL) {
+			return;
+		}
+		task = tusk_mutex_owner(task->blocked_on);
+	}
+}
+
+/* Makes `task` the owner of `mutex` and applies any ceiling. */
+static void take_mutex(tusk_mutex_t *mutex, tcb_t *task)
+{
+	// Remaining waiters keep the owner's release on the slow path
+	mutex->lock = (uintptr_t)task |
+		      (mutex->waiting_list.head != NULL ? MUTEX_WAITERS : 0);
+	mutex->next_held = task->held_mutexes;
+	task->held_mutexes = mutex;
+	if (mutex->protocol == TUSK_MUTEX_CEILING) {
+		update_inherited_priority(task);
+	}
+}
+
+static void drop_held_mutex(tcb_t *task, tusk_mutex_t *mutex)
+{
+	tusk_mutex_t **link = &task->held_mutexes;
+
+	while (*link != NULL && *link != mutex) {
+		link = &(*link)->next_held;
+	}
+	if (*link == mutex) {
+		*link = mutex->next_held;
+	}
+	mutex->next_held = NULL;
+}
+
+/*
+ * Gives a mutex its owner has dropped to the most urgent waiter, or unlocks
+ * it if there is none. Returns the new owner, which the caller must wake.
+ */
+static tcb_t *pass_mutex_on(tusk_mutex_t *mutex)
+{
+	tcb_t *waiter = remove_from_wait_list(&mutex->waiting_list);
+
+	if (waiter == NULL) {
+		// No tasks waiting (any that were timed out), just unlock
+		mutex->lock = MUTEX_UNLOCKED;
+		return NULL;
+	}
+
+	// The new owner inherits from the waiters that are left behind it
+	waiter->blocked_on = NULL;
+	take_mutex(mutex, waiter);
+	update_inherited_priority(waiter);
+	TRACE_EVENT(TRACE_MUTEX_WAKE, waiter, TRACE_OBJECT(mutex));
+	return waiter;
 }
 
 void tusk_mutex_init(tusk_mutex_t *mutex)
 {
-	mutex->locked = MUTEX_UNLOCKED;
-	mutex->owner = NULL;
-	mutex->waiting_list = NULL;
+	mutex->lock = MUTEX_UNLOCKED;
+	mutex->protocol = TUSK_MUTEX_INHERIT;
+	mutex->ceiling = 0;
+	mutex->recursive = 0;
+	mutex->depth = 0;
+	wait_queue_init(&mutex->waiting_list);
+	mutex->next_held = NULL;
+}
+
+int tusk_mutex_init_ceiling(tusk_mutex_t *mutex, uint8_t ceiling)
+{
+	if (ceiling >= TUSK_MAX_PRIORITIES) {
+		return -1;
+	}
+	tusk_mutex_init(mutex);
+	mutex->protocol = TUSK_MUTEX_CEILING;
+	mutex->ceiling = ceiling;
+	return 0;
+}
+
+void tusk_mutex_init_recursive(tusk_mutex_t *mutex)
+{
+	tusk_mutex_init(mutex);
+	mutex->recursive = 1;
 }
 
 void tusk_mutex_acquire(tusk_mutex_t *mutex)
 {
-	__disable_irq(); // Enter critical section
-	if (mutex->locked == MUTEX_LOCKED) {
-		// Mutex is taken, block the current task
-		current_tcb->state = TASK_BLOCKED;
-		add_to_wait_list(&mutex->waiting_list, current_tcb);
-		__enable_irq(); // Re-enable interrupts BEFORE scheduling
-		*(volatile uint32_t *)0xE000ED04 |=
-			(1 << 28); // Trigger scheduler
-	} else {
+	tusk_mutex_acquire_timeout(mutex, TUSK_WAIT_FOREVER);
+}
+
+int tusk_mutex_acquire_timeout(tusk_mutex_t *mutex, uint32_t timeout)
+{
+	tcb_t *self = current_tcb;
+
+	// Only the owner can make itself the owner, so this needs no lock
+	if (mutex->recursive && tusk_mutex_owner(mutex) == self) {
+		mutex->depth++;
+		return 0;
+	}
+
+	// Fast path: take a free inheritance mutex without masking interrupts.
+	// A ceiling mutex always changes the owner's priority, so it cannot.
+	if (mutex->protocol == TUSK_MUTEX_INHERIT) {
+		// Until the mutex is on our held list, this is how
+		// tusk_delete_task() finds it
+		self->pending_mutex = mutex;
+		if (port_atomic_cas_ptr(&mutex->lock, MUTEX_UNLOCKED,
+					(uintptr_t)self)) {
+			mutex->next_held = self->held_mutexes;
+			self->held_mutexes = mutex;
+			port_memory_barrier();
+			self->pending_mutex = NULL;
+			// Someone may have blocked before the mutex was on our
+			// held list, in which case their priority did not reach
+			// us yet
+			if (mutex->lock & MUTEX_WAITERS) {
+				port_disable_interrupts();
+				update_inherited_priority(self);
+				port_enable_interrupts();
+			}
+			return 0;
+		}
+		self->pending_mutex = NULL;
+	}
+
+	port_disable_interrupts(); // Enter critical section
+	if (mutex->lock == MUTEX_UNLOCKED) {
 		// Mutex is free, take it
-		mutex->locked = MUTEX_LOCKED;
-		mutex->owner = current_tcb;
-		__enable_irq(); // Exit critical section
+		take_mutex(mutex, self);
+		port_enable_interrupts(); // Exit critical section
+		return 0;
+	}
+	if (timeout == TUSK_NO_WAIT) {
+		port_enable_interrupts();
+		return -1;
 	}
+
+	// Mutex is taken, block the current task. The flag makes the owner's
+	// release fail its fast path and come here to hand the mutex over.
+	TRACE_EVENT(TRACE_MUTEX_BLOCK, self, TRACE_OBJECT(mutex));
+	mutex->lock |= MUTEX_WAITERS;
+	block_current_task_timeout(timeout);
+	add_to_wait_list(&mutex->waiting_list, self);
+	self->blocked_on = mutex;
+	// Lend our priority to the owner, and to whoever it waits for
+	update_inherited_priority(tusk_mutex_owner(mutex));
+	port_enable_interrupts(); // Re-enable interrupts BEFORE scheduling
+	trigger_context_switch();
+
+	// The releasing task hands the mutex over before waking us, so if we
+	// do not own it now, the timeout took us off the queue.
+	return tusk_mutex_owner(mutex) == self ? 0 : -1;
 }
 
 void tusk_mutex_release(tusk_mutex_t *mutex)
 {
-	__disable_irq(); // Enter critical section
-	if (mutex->owner == current_tcb) {
-		tcb_t *unblocked_task =
-			remove_from_wait_list(&mutex->waiting_list);
+	tcb_t *self = current_tcb;
+
+	if (mutex->depth > 0 && tusk_mutex_owner(mutex) == self) {
+		mutex->depth--;
+		return;
+	}
+
+	// Fast path: nobody waits and the mutex is the last one we took, so
+	// dropping it changes neither our priority nor anybody else's
+	if (mutex->lock == (uintptr_t)self && self->held_mutexes == mutex &&
+	    mutex->protocol == TUSK_MUTEX_INHERIT) {
+		// Unlink before unlocking: once the lock word is clear, the
+		// next owner may link the mutex into its own list
+		tusk_mutex_t *next_held = mutex->next_held;
+		self->pending_mutex = mutex;
+		port_memory_barrier();
+		self->held_mutexes = next_held;
+		mutex->next_held = NULL;
+		if (port_atomic_cas_ptr(&mutex->lock, (uintptr_t)self,
+					MUTEX_UNLOCKED)) {
+			self->pending_mutex = NULL;
+			return;
+		}
+		// A task blocked in the meantime, hand the mutex over below
+		mutex->next_held = next_held;
+		self->held_mutexes = mutex;
+		port_memory_barrier();
+		self->pending_mutex = NULL;
+	}
+
+	port_disable_interrupts(); // Enter critical section
+	if (tusk_mutex_owner(mutex) == self) {
+		drop_held_mutex(self, mutex);
+		tcb_t *unblocked_task = pass_mutex_on(mutex);
+
+		// Drop any boost we no longer need before the waiter competes
+		uint8_t priority = self->priority;
+		update_inherited_priority(self);
 		if (unblocked_task != NULL) {
-			// Give the mutex to the next waiting task
-			mutex->owner = unblocked_task;
-			unblocked_task->state = TASK_READY;
-		} else {
-			// No tasks waiting, just unlock
-			mutex->locked = MUTEX_UNLOCKED;
-			mutex->owner = NULL;
+			wake_task(unblocked_task);
+		}
+		if (self->priority < priority) {
+			trigger_context_switch();
 		}
 	}
-	__enable_irq(); // Exit critical section
+	port_enable_interrupts(); // Exit critical section
 }
 
 void tusk_semaphore_init(rtos_semaphore_t *semaphore, int32_t initial_count)
 {
 	semaphore->count = initial_count;
-	semaphore->waiting_list = NULL;
+	wait_queue_init(&semaphore->waiting_list);
 }
 
 void tusk_semaphore_wait(rtos_semaphore_t *semaphore)
 {
-	__disable_irq();
-	semaphore->count--;
-	if (semaphore->count < 0) {
-		// Resource not available, block the task
-		current_tcb->state = TASK_BLOCKED;
-		add_to_wait_list(&semaphore->waiting_list, current_tcb);
-		__enable_irq();
-		*(volatile uint32_t *)0xE000ED04 |=
-			(1 << 28); // Trigger scheduler
-	} else {
-		__enable_irq();
+	tusk_semaphore_wait_timeout(semaphore, TUSK_WAIT_FOREVER);
+}
+
+int tusk_semaphore_wait_timeout(rtos_semaphore_t *semaphore, uint32_t timeout)
+{
+	volatile uint32_t *count = (volatile uint32_t *)&semaphore->count;
+
+	// Fast path: take a unit without masking interrupts
+	for (int32_t units = semaphore->count; units > 0;
+	     units = semaphore->count) {
+		if (port_atomic_cas(count, units, units - 1)) {
+			return 0;
+		}
 	}
+
+	port_disable_interrupts();
+	if (semaphore->count > 0) {
+		semaphore->count--;
+		port_enable_interrupts();
+		return 0;
+	}
+	if (timeout == TUSK_NO_WAIT) {
+		port_enable_interrupts();
+		return -1;
+	}
+
+	// Resource not available, block the task. The posting task hands its
+	// unit straight to us. A count of -1 keeps posts off their fast path
+	// for as long as we may be waiting.
+	TRACE_EVENT(TRACE_SEM_BLOCK, current_tcb, TRACE_OBJECT(semaphore));
+	semaphore->count = -1;
+	block_current_task_timeout(timeout);
+	add_to_wait_list(&semaphore->waiting_list, current_tcb);
+	port_enable_interrupts();
+	trigger_context_switch();
+
+	return current_tcb->timed_out ? -1 : 0;
 }
 
 void tusk_semaphore_post(rtos_semaphore_t *semaphore)
 {
-	__disable_irq();
-	semaphore->count++;
-	if (semaphore->count <= 0) {
-		// Tasks are waiting, unblock one
-		tcb_t *unblocked_task =
-			remove_from_wait_list(&semaphore->waiting_list);
-		if (unblocked_task != NULL) {
-			unblocked_task->state = TASK_READY;
+	volatile uint32_t *count = (volatile uint32_t *)&semaphore->count;
+
+	// Fast path: nobody waits, just add a unit
+	for (int32_t units = semaphore->count; units >= 0;
+	     units = semaphore->count) {
+		if (port_atomic_cas(count, units, units + 1)) {
+			return;
 		}
 	}
-	__enable_irq();
+
+	port_disable_interrupts();
+	tcb_t *unblocked_task = remove_from_wait_list(&semaphore->waiting_list);
+	if (unblocked_task != NULL) {
+		// Tasks are waiting, hand the unit to the first one
+		TRACE_EVENT(TRACE_SEM_WAKE, unblocked_task,
+			    TRACE_OBJECT(semaphore));
+		if (semaphore->waiting_list.head == NULL) {
+			semaphore->count = 0;
+		}
+		wake_task(unblocked_task);
+	} else {
+		// Every waiter timed out, so the count may still read -1
+		if (semaphore->count < 0) {
+			semaphore->count = 0;
+		}
+		semaphore->count++;
+	}
+	port_enable_interrupts();
 }
 
-/* --- Helper functions for managing wait lists --- */
+/* --- Event Groups --- */
+
+// Stored in tcb->event_options while a task waits on an event group
+#define EVENT_WAIT_ALL 0x01U
+#define EVENT_CLEAR_ON_EXIT 0x02U
 
-void add_to_wait_list(struct tcb **list, tcb_t *task)
+static uint8_t event_condition_met(uint32_t flags, uint32_t mask,
+				   uint8_t options)
 {
-	task->wait_next = NULL;
-	if (*list == NULL) {
-		*list = task;
+	if (options & EVENT_WAIT_ALL) {
+		return (flags & mask) == mask;
+	}
+	return (flags & mask) != 0;
+}
+
+/* Sets flags and wakes every satisfied waiter. Interrupts must be disabled. */
+static uint32_t set_event_flags(tusk_event_group_t *group, uint32_t bits)
+{
+	uint32_t flags = group->flags | bits;
+	uint32_t clear_bits = 0;
+	tcb_t *task = group->waiting_list.head;
+
+	group->flags = flags;
+
+	// Every waiter is judged against the same flags, so a waiter that
+	// clears on exit cannot hide a flag from the ones queued behind it.
+	while (task != NULL) {
+		tcb_t *next = task->wait_next;
+
+		if (event_condition_met(flags, task->event_bits,
+					task->event_options)) {
+			if (task->event_options & EVENT_CLEAR_ON_EXIT) {
+				clear_bits |= task->event_bits;
+			}
+			task->event_bits = flags;
+			unlink_from_wait_list(task);
+			TRACE_EVENT(TRACE_EVENT_WAKE, task, TRACE_OBJECT(group));
+			wake_task(task);
+		}
+		task = next;
+	}
+
+	group->flags = flags & ~clear_bits;
+	return flags;
+}
+
+void tusk_event_init(tusk_event_group_t *group)
+{
+	group->flags = 0;
+	wait_queue_init(&group->waiting_list);
+}
+
+uint32_t tusk_event_set(tusk_event_group_t *group, uint32_t bits)
+{
+	port_disable_interrupts();
+	uint32_t flags = set_event_flags(group, bits);
+	port_enable_interrupts();
+	return flags;
+}
+
+uint32_t tusk_event_set_from_isr(tusk_event_group_t *group, uint32_t bits)
+{
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	uint32_t flags = set_event_flags(group, bits);
+	port_clear_interrupt_mask_from_isr(mask);
+	return flags;
+}
+
+uint32_t tusk_event_clear(tusk_event_group_t *group, uint32_t bits)
+{
+	port_disable_interrupts();
+	uint32_t flags = group->flags;
+	group->flags = flags & ~bits;
+	port_enable_interrupts();
+	return flags;
+}
+
+uint32_t tusk_event_wait(tusk_event_group_t *group, uint32_t mask,
+			 uint8_t wait_mode, uint8_t clear_on_exit,
+			 uint32_t timeout)
+{
+	uint8_t options = (wait_mode == TUSK_EVENT_WAIT_ALL) ? EVENT_WAIT_ALL : 0;
+	uint32_t flags;
+
+	if (clear_on_exit) {
+		options |= EVENT_CLEAR_ON_EXIT;
+	}
+
+	port_disable_interrupts();
+	flags = group->flags;
+	if (event_condition_met(flags, mask, options)) {
+		if (options & EVENT_CLEAR_ON_EXIT) {
+			group->flags = flags & ~mask;
+		}
+		port_enable_interrupts();
+		return flags;
+	}
+	if (timeout == TUSK_NO_WAIT || mask == 0) {
+		port_enable_interrupts();
+		return flags;
+	}
+
+	// The setter checks our condition, clears our bits and leaves the
+	// flags it saw in event_bits before waking us.
+	TRACE_EVENT(TRACE_EVENT_BLOCK, current_tcb, TRACE_OBJECT(group));
+	current_tcb->event_bits = mask;
+	current_tcb->event_options = options;
+	block_current_task_timeout(timeout);
+	add_to_wait_list(&group->waiting_list, current_tcb);
+	port_enable_interrupts();
+	trigger_context_switch();
+
+	port_disable_interrupts();
+	flags = current_tcb->timed_out ? group->flags : current_tcb->event_bits;
+	port_enable_interrupts();
+	return flags;
+}
+
+/* --- Task Notifications --- */
+
+/* Updates the notification word and wakes the task if it waits. Interrupts must be disabled. */
+static void notify_task(tcb_t *task, uint32_t value, uint8_t action)
+{
+	switch (action) {
+	case TUSK_NOTIFY_SET_BITS:
+		task->notify_value |= value;
+		break;
+	case TUSK_NOTIFY_INCREMENT:
+		task->notify_value++;
+		break;
+	default:
+		task->notify_value = value;
+		break;
+	}
+
+	// A waiter whose timeout already made it ready only needs the state
+	if (task->notify_state == NOTIFY_WAITING && task->state == TASK_BLOCKED) {
+		task->notify_state = NOTIFY_PENDING;
+		TRACE_EVENT(TRACE_NOTIFY_WAKE, task, action);
+		wake_task(task);
 	} else {
-		tcb_t *temp = *list;
-		while (temp->wait_next != NULL) {
-			temp = temp->wait_next;
+		task->notify_state = NOTIFY_PENDING;
+	}
+}
+
+static uint8_t notify_target_valid(const tcb_t *task, uint8_t action)
+{
+	return task != NULL && action <= TUSK_NOTIFY_OVERWRITE &&
+	       task->state != TASK_INACTIVE && task->state != TASK_DELETED;
+}
+
+int tusk_notify(tcb_t *task, uint32_t value, uint8_t action)
+{
+	port_disable_interrupts();
+	if (!notify_target_valid(task, action)) {
+		port_enable_interrupts();
+		return -1;
+	}
+	notify_task(task, value, action);
+	port_enable_interrupts();
+	return 0;
+}
+
+int tusk_notify_from_isr(tcb_t *task, uint32_t value, uint8_t action)
+{
+	uint32_t mask = port_set_interrupt_mask_from_isr();
+	int result = -1;
+
+	if (notify_target_valid(task, action)) {
+		notify_task(task, value, action);
+		result = 0;
+	}
+	port_clear_interrupt_mask_from_isr(mask);
+	return result;
+}
+
+int tusk_notify_wait(uint32_t clear_mask, uint32_t *value, uint32_t timeout)
+{
+	int result = -1;
+
+	port_disable_interrupts();
+	if (current_tcb->notify_state != NOTIFY_PENDING && timeout != TUSK_NO_WAIT) {
+		TRACE_EVENT(TRACE_NOTIFY_BLOCK, current_tcb, 0);
+		current_tcb->notify_state = NOTIFY_WAITING;
+		block_current_task_timeout(timeout);
+		port_enable_interrupts();
+		trigger_context_switch();
+		port_disable_interrupts();
+	}
+
+	// Still waiting means the delay list woke us: the wait timed out
+	if (current_tcb->notify_state == NOTIFY_PENDING) {
+		if (value != NULL) {
+			*value = current_tcb->notify_value;
 		}
-		temp->wait_next = task;
+		current_tcb->notify_value &= ~clear_mask;
+		result = 0;
 	}
+	current_tcb->notify_state = NOTIFY_NONE;
+	port_enable_interrupts();
+	return result;
 }
 
-tcb_t *remove_from_wait_list(struct tcb **list)
+/* --- Helper functions for managing ready queues --- */
+
+void add_to_ready_list(tcb_t *task)
 {
-	if (*list == NULL) {
-		return NULL;
+	uint8_t priority = task->priority;
+	tcb_t *head = ready_list[priority];
+	tcb_t *next = head;
+
+	task->state = TASK_READY;
+	if (head == NULL) {
+		task->next_tcb = task;
+		task->prev_tcb = task;
+		ready_list[priority] = task;
+		ready_bitmap |= (1UL << priority);
+		return;
+	}
+
+#if TUSK_USE_EDF
+	// The EDF level is sorted by absolute deadline, earliest first. Tasks
+	// with equal deadlines keep FIFO order.
+	if (priority == TUSK_EDF_PRIORITY) {
+		while (!deadline_before(task, next)) {
+			next = next->next_tcb;
+			if (next == head) {
+				break;
+			}
+		}
+	}
+#endif
+
+	// Insert just before `next`. For plain round-robin levels that is the
+	// head, so the task ends up at the tail.
+	task->next_tcb = next;
+	task->prev_tcb = next->prev_tcb;
+	next->prev_tcb->next_tcb = task;
+	next->prev_tcb = task;
+
+#if TUSK_USE_EDF
+	if (priority == TUSK_EDF_PRIORITY && deadline_before(task, head)) {
+		ready_list[priority] = task;
+	}
+#endif
+}
+
+void remove_from_ready_list(tcb_t *task)
+{
+	uint8_t priority = task->priority;
+
+	if (task->next_tcb == task) {
+		// Last task of this priority
+		ready_list[priority] = NULL;
+		ready_bitmap &= ~(1UL << priority);
+	} else {
+		task->prev_tcb->next_tcb = task->next_tcb;
+		task->next_tcb->prev_tcb = task->prev_tcb;
+		if (ready_list[priority] == task) {
+			ready_list[priority] = task->next_tcb;
+		}
+	}
+	task->next_tcb = NULL;
+	task->prev_tcb = NULL;
+}
+
+/* --- Helper functions for managing the delay list --- */
+
+void add_to_delay_list(tcb_t *task, uint32_t wakeup_time)
+{
+	tcb_t *prev = NULL;
+	tcb_t *next = delay_list;
+
+	// Keep the list sorted; tasks with equal wakeup times stay in FIFO order.
+	// The signed difference keeps the comparison correct across tick wrap.
+	while (next != NULL && (int32_t)(next->wakeup_time - wakeup_time) <= 0) {
+		prev = next;
+		next = next->delay_next;
+	}
+
+	task->wakeup_time = wakeup_time;
+	task->delay_prev = prev;
+	task->delay_next = next;
+	if (next != NULL) {
+		next->delay_prev = task;
+	}
+	if (prev != NULL) {
+		prev->delay_next = task;
+	} else {
+		delay_list = task;
+	}
+}
+
+void remove_from_delay_list(tcb_t *task)
+{
+	if (task->delay_prev != NULL) {
+		task->delay_prev->delay_next = task->delay_next;
+	} else {
+		delay_list = task->delay_next;
+	}
+	if (task->delay_next != NULL) {
+		task->delay_next->delay_prev = task->delay_prev;
+	}
+	task->delay_next = NULL;
+	task->delay_prev = NULL;
+}
+
+/* --- Helper functions for managing wait lists --- */
+
+void add_to_wait_list(wait_queue_t *queue, tcb_t *task)
+{
+	tcb_t *prev = queue->tail;
+
+	// Sorted by priority, highest first; equal priorities stay in FIFO
+	// order. Walking back from the tail makes the common case, a waiter no
+	// more urgent than the last one, a constant-time append.
+	while (prev != NULL && prev->priority < task->priority) {
+		prev = prev->wait_prev;
+	}
+
+	task->wait_prev = prev;
+	task->wait_next = (prev != NULL) ? prev->wait_next : queue->head;
+	task->wait_list = queue;
+	if (task->wait_next != NULL) {
+		task->wait_next->wait_prev = task;
+	} else {
+		queue->tail = task;
+	}
+	if (prev != NULL) {
+		prev->wait_next = task;
+	} else {
+		queue->head = task;
+	}
+}
+
+tcb_t *remove_from_wait_list(wait_queue_t *queue)
+{
+	tcb_t *task = queue->head;
+
+	if (task != NULL) {
+		unlink_from_wait_list(task);
 	}
-	tcb_t *task = *list;
-	*list = task->wait_next;
-	task->wait_next = NULL;
 	return task;
 }
+
+void unlink_from_wait_list(tcb_t *task)
+{
+	wait_queue_t *queue = task->wait_list;
+
+	if (task->wait_prev != NULL) {
+		task->wait_prev->wait_next = task->wait_next;
+	} else {
+		queue->head = task->wait_next;
+	}
+	if (task->wait_next != NULL) {
+		task->wait_next->wait_prev = task->wait_prev;
+	} else {
+		queue->tail = task->wait_prev;
+	}
+	task->wait_next = NULL;
+	task->wait_prev = NULL;
+	task->wait_list = NULL;
+}
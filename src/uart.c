@@ -3,6 +3,8 @@
  * It writes directly to the USART1 data register.
  */
 
+#include "../include/serial.h"
+
 // USART1 Data Register on the STM32F4 series
 #define UART_DR (*(volatile unsigned int *)0x40011004)
 
@@ -19,3 +21,16 @@ void serial_print(const char *str)
 		UART_DR = (*str++);
 	}
 }
+
+void serial_print_dec(uint32_t value)
+{
+	char buffer[11];
+	char *digit = &buffer[sizeof(buffer) - 1];
+
+	*digit = '\0';
+	do {
+		*(--digit) = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	serial_print(digit);
+}
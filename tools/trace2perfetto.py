@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Convert a Tusk RTOS scheduler trace into Chrome/Perfetto trace JSON.
+
+The kernel, built with TUSK_USE_TRACE=1, emits trace records over the serial
+port from tusk_trace_drain() (see include/trace.h). Capture the serial output
+to a file, for example with `make run | tee serial.log`, and run:
+
+    tools/trace2perfetto.py serial.log -o trace.json
+
+Open trace.json at https://ui.perfetto.dev or chrome://tracing. Every task
+gets its own track showing when it was running, with kernel events drawn as
+instant markers. Lines that are not trace records are ignored, so the log
+may contain regular console output as well.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+RECORD = re.compile(r"@([HTL])([0-9a-f]+)")
+
+TASK_IDLE = 0xFF
+TASK_KERNEL = 0xFE
+
+TASK_SWITCH = 0x01
+QUEUE_SEND = 0x20
+QUEUE_RECEIVE = 0x21
+
+EVENTS = {
+    0x01: "switch",
+    0x02: "create",
+    0x03: "delete",
+    0x04: "delay",
+    0x05: "delay_expire",
+    0x06: "time_slice",
+    0x07: "priority_change",
+    0x08: "wait_timeout",
+    0x10: "mutex_block",
+    0x11: "mutex_wake",
+    0x12: "sem_block",
+    0x13: "sem_wake",
+    0x14: "notify_block",
+    0x15: "notify_wake",
+    0x16: "event_block",
+    0x17: "event_wake",
+    0x20: "queue_send",
+    0x21: "queue_receive",
+    0x22: "queue_full",
+    0x23: "queue_empty",
+}
+
+PID = 1
+
+
+def task_name(index):
+    if index == TASK_IDLE:
+        return "idle"
+    if index == TASK_KERNEL:
+        return "kernel"
+    return "task %d" % index
+
+
+def parse(lines, default_hz):
+    """Returns the (time_us, event, task, arg) records sorted by time and the lost count."""
+    hz = default_hz
+    base = 0
+    last = None
+    events = []
+    lost = 0
+
+    for line in lines:
+        for kind, digits in RECORD.findall(line):
+            if kind == "H" and len(digits) == 8:
+                hz = int(digits, 16)
+            elif kind == "L" and len(digits) == 8:
+                lost += int(digits, 16)
+            elif kind == "T" and len(digits) == 16:
+                stamp = int(digits[0:8], 16)
+                # Unwrap the 32-bit timestamp. Events may be slightly out
+                # of order, so only a large backwards jump counts as a wrap.
+                if last is not None and stamp < last and last - stamp > 1 << 31:
+                    base += 1 << 32
+                last = stamp
+                events.append(
+                    (
+                        (base + stamp) * 1e6 / hz,
+                        int(digits[8:10], 16),
+                        int(digits[10:12], 16),
+                        int(digits[12:16], 16),
+                    )
+                )
+
+    events.sort(key=lambda event: event[0])
+    return events, lost
+
+
+def convert(events):
+    trace = []
+    tasks = set()
+    running = None
+    running_since = None
+
+    for time, event, task, arg in events:
+        tasks.add(task)
+        if event == TASK_SWITCH:
+            # Close the slice of the task that was running until now
+            previous = running if running is not None else arg
+            if running_since is not None:
+                trace.append(
+                    {
+                        "name": "running",
+                        "ph": "X",
+                        "pid": PID,
+                        "tid": previous,
+                        "ts": running_since,
+                        "dur": time - running_since,
+                    }
+                )
+            tasks.add(previous)
+            running = task
+            running_since = time
+            continue
+
+        name = EVENTS.get(event, "event 0x%02x" % event)
+        trace.append(
+            {
+                "name": name,
+                "ph": "i",
+                "s": "t",
+                "pid": PID,
+                "tid": task,
+                "ts": time,
+                "args": {"arg": arg},
+            }
+        )
+        if event in (QUEUE_SEND, QUEUE_RECEIVE):
+            trace.append(
+                {
+                    "name": "queue depth",
+                    "ph": "C",
+                    "pid": PID,
+                    "ts": time,
+                    "args": {"messages": arg},
+                }
+            )
+
+    trace.append(
+        {"name": "process_name", "ph": "M", "pid": PID, "args": {"name": "Tusk RTOS"}}
+    )
+    for task in sorted(tasks):
+        trace.append(
+            {
+                "name": "thread_name",
+                "ph": "M",
+                "pid": PID,
+                "tid": task,
+                "args": {"name": task_name(task)},
+            }
+        )
+    return trace
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "log", nargs="?", help="captured serial output (default: stdin)"
+    )
+    parser.add_argument(
+        "-o", "--output", help="trace JSON to write (default: stdout)"
+    )
+    parser.add_argument(
+        "--hz",
+        type=int,
+        default=16000000,
+        help="timestamp rate if the log has no @H header (default: 16000000)",
+    )
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors="replace") as log:
+            events, lost = parse(log, args.hz)
+    else:
+        events, lost = parse(sys.stdin, args.hz)
+
+    result = {"traceEvents": convert(events), "displayTimeUnit": "ns"}
+    if args.output:
+        with open(args.output, "w") as output:
+            json.dump(result, output)
+    else:
+        json.dump(result, sys.stdout)
+        sys.stdout.write("\n")
+
+    print(
+        "%d events converted, %d lost" % (len(events), lost), file=sys.stderr
+    )
+
+
+if __name__ == "__main__":
+    main()